@@ -0,0 +1,31 @@
+#!/bin/bash -e
+
+# usage: check-isa-objects.sh <object>...
+# The micro kernel objects micro_kernel_<isa>.* are compiled with -mavx and
+# -mavx2. Inline functions and templates they instantiate are emitted as weak
+# symbols with AVX instructions, and the linker may keep that copy for the
+# whole program, which then crashes with SIGILL on CPUs without AVX. Only
+# code of the namespace micro_kernel::detail::<isa> may be defined weakly,
+# every other weak symbol (std::, Vc::, shared helpers) fails the check.
+
+status=0
+for object in "$@"; do
+    isa=$(basename "$object" | sed -n 's/^.*micro_kernel_\([a-z0-9]*\)\..*$/\1/p')
+    if [ -z "$isa" ]; then
+        echo "error: $object is not a micro_kernel_<isa> object"
+        status=1
+        continue
+    fi
+    # mangled prefix of micro_kernel::detail::<isa>, also for local entities
+    # (lambdas, _ZZ, nested ones _ZZZ) and their guard variables (_ZGVZ)
+    own="^_Z(Z*|GVZ+)N[VKR]*12micro_kernel6detail${#isa}${isa}"
+    foreign=$(nm "$object" | awk '$2 ~ /^[WVu]$/ { print $3 }' \
+        | grep -Ev "$own" || true)
+    if [ -n "$foreign" ]; then
+        echo "error: $object defines weak symbols outside" \
+             "micro_kernel::detail::$isa:"
+        echo "$foreign" | c++filt
+        status=1
+    fi
+done
+exit $status
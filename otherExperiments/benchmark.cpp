@@ -6,6 +6,7 @@
 #include <iomanip>
 
 #include "mult.hpp"
+#include "util/perf_counters.hpp"
 
 inline void *align( size_t alignment, size_t size,
                     void *&ptr, std::size_t space ) {
@@ -69,6 +70,10 @@ int main (int argc, char **argv) {
     return 0;
   }
 
+  // opened before the timed region, the counters cover all threads
+  util::perf_counters counters;
+  counters.start();
+
   auto startTime = std::chrono::high_resolution_clock::now();
 
   if (strcmp(argv[1], "naive") == 0) {
@@ -131,6 +136,7 @@ int main (int argc, char **argv) {
 
 
   auto stopTime = std::chrono::high_resolution_clock::now();
+  counters.stop();
   auto duration = stopTime - startTime;
   double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() / 1000.0;
   double gflop = flops / 1E9;
@@ -138,6 +144,7 @@ int main (int argc, char **argv) {
   std::cout << "seconds: " << seconds << std::endl;
 
   std::cout << (gflop / seconds) << " Gflops" << std::endl;
+  counters.print(argv[1]);
   
 
   double check = 0;
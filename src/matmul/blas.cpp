@@ -0,0 +1,160 @@
+#include "blas.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <exception>
+
+#include "matmul.hpp"
+
+namespace {
+
+// below, the packing costs more than the naive loops
+const double naive_flops_limit = 2.0 * 32 * 32 * 32;
+
+// like the reference xerbla, but returns instead of stopping the program
+void report_illegal(const char *routine, int parameter) {
+  std::fprintf(stderr,
+               " ** On entry to %s parameter number %d had an illegal value\n",
+               routine, parameter);
+}
+
+// row-major, the arguments are valid
+void gemm_row_major(const char *routine, bool transposed_A, bool transposed_B,
+                    int M, int N, int K, double alpha, const double *A,
+                    int lda, const double *B, int ldb, double beta, double *C,
+                    int ldc) {
+  if (M == 0 || N == 0 || ((alpha == 0.0 || K == 0) && beta == 1.0)) {
+    return;
+  }
+  matmul::options<double> opt;
+  opt.transposed_A = transposed_A;
+  opt.transposed_B = transposed_B;
+  opt.alpha = alpha;
+  opt.beta = beta;
+  double flops = 2.0 * static_cast<double>(M) * static_cast<double>(N) *
+                 static_cast<double>(K);
+  matmul::engine e = flops <= naive_flops_limit ? matmul::engine::naive
+                                                : matmul::engine::kernel_tiled;
+  try {
+    matmul::gemm(e,
+                 {static_cast<size_t>(M), static_cast<size_t>(N),
+                  static_cast<size_t>(K)},
+                 {A, B, C},
+                 {static_cast<size_t>(lda), static_cast<size_t>(ldb),
+                  static_cast<size_t>(ldc)},
+                 opt);
+  } catch (const std::exception &ex) {
+    // no exceptions through the C interface
+    std::fprintf(stderr, " ** %s failed: %s\n", routine, ex.what());
+  }
+}
+
+// 0 if trans isn't a transpose flag
+int fortran_transpose(char trans) {
+  char t = static_cast<char>(std::toupper(static_cast<unsigned char>(trans)));
+  return t == 'N' || t == 'T' || t == 'C' ? t : 0;
+}
+}
+
+extern "C" {
+
+void cblas_dgemm(const enum CBLAS_ORDER Order,
+                 const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int M, const int N,
+                 const int K, const double alpha, const double *A,
+                 const int lda, const double *B, const int ldb,
+                 const double beta, double *C, const int ldc) {
+  const char *routine = "cblas_dgemm";
+  auto is_transpose = [](CBLAS_TRANSPOSE t) {
+    return t == CblasNoTrans || t == CblasTrans || t == CblasConjTrans;
+  };
+  if (Order != CblasRowMajor && Order != CblasColMajor) {
+    return report_illegal(routine, 1);
+  }
+  if (!is_transpose(TransA)) {
+    return report_illegal(routine, 2);
+  }
+  if (!is_transpose(TransB)) {
+    return report_illegal(routine, 3);
+  }
+  if (M < 0) {
+    return report_illegal(routine, 4);
+  }
+  if (N < 0) {
+    return report_illegal(routine, 5);
+  }
+  if (K < 0) {
+    return report_illegal(routine, 6);
+  }
+  // real matrices, the conjugate transpose is the transpose
+  bool transposed_A = TransA != CblasNoTrans;
+  bool transposed_B = TransB != CblasNoTrans;
+  // columns of the stored matrices in the row-major view
+  int A_cols, B_cols, C_cols;
+  if (Order == CblasRowMajor) {
+    A_cols = transposed_A ? M : K;
+    B_cols = transposed_B ? K : N;
+    C_cols = N;
+  } else {
+    A_cols = transposed_A ? K : M;
+    B_cols = transposed_B ? N : K;
+    C_cols = M;
+  }
+  if (lda < std::max(1, A_cols)) {
+    return report_illegal(routine, 9);
+  }
+  if (ldb < std::max(1, B_cols)) {
+    return report_illegal(routine, 11);
+  }
+  if (ldc < std::max(1, C_cols)) {
+    return report_illegal(routine, 14);
+  }
+  if (Order == CblasRowMajor) {
+    gemm_row_major(routine, transposed_A, transposed_B, M, N, K, alpha, A,
+                   lda, B, ldb, beta, C, ldc);
+  } else {
+    // a column-major matrix is its transpose in row-major order:
+    // C^T = op(B)^T op(A)^T
+    gemm_row_major(routine, transposed_B, transposed_A, N, M, K, alpha, B,
+                   ldb, A, lda, beta, C, ldc);
+  }
+}
+
+void dgemm_(const char *transa, const char *transb, const int *m,
+            const int *n, const int *k, const double *alpha, const double *a,
+            const int *lda, const double *b, const int *ldb,
+            const double *beta, double *c, const int *ldc) {
+  const char *routine = "DGEMM ";
+  int trans_A = fortran_transpose(*transa);
+  int trans_B = fortran_transpose(*transb);
+  if (trans_A == 0) {
+    return report_illegal(routine, 1);
+  }
+  if (trans_B == 0) {
+    return report_illegal(routine, 2);
+  }
+  if (*m < 0) {
+    return report_illegal(routine, 3);
+  }
+  if (*n < 0) {
+    return report_illegal(routine, 4);
+  }
+  if (*k < 0) {
+    return report_illegal(routine, 5);
+  }
+  bool transposed_A = trans_A != 'N';
+  bool transposed_B = trans_B != 'N';
+  if (*lda < std::max(1, transposed_A ? *k : *m)) {
+    return report_illegal(routine, 8);
+  }
+  if (*ldb < std::max(1, transposed_B ? *n : *k)) {
+    return report_illegal(routine, 10);
+  }
+  if (*ldc < std::max(1, *m)) {
+    return report_illegal(routine, 13);
+  }
+  gemm_row_major(routine, transposed_B, transposed_A, *n, *m, *k, *alpha, b,
+                 *ldb, a, *lda, *beta, c, *ldc);
+}
+}
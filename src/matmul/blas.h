@@ -0,0 +1,37 @@
+#pragma once
+
+/* BLAS compatible entry points of libmatmul, computed by kernel_tiled (naive
+ * loops for tiny products). Linking libmatmul (or preloading libmatmul.so)
+ * replaces the dgemm of a reference BLAS. Include after cblas.h if both are
+ * used. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CBLAS_H
+enum CBLAS_ORDER { CblasRowMajor = 101, CblasColMajor = 102 };
+enum CBLAS_TRANSPOSE {
+  CblasNoTrans = 111,
+  CblasTrans = 112,
+  CblasConjTrans = 113
+};
+#endif
+
+/* C = alpha * op(A) * op(B) + beta * C, op(A) is M x K, op(B) is K x N */
+void cblas_dgemm(const enum CBLAS_ORDER Order,
+                 const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int M, const int N,
+                 const int K, const double alpha, const double *A,
+                 const int lda, const double *B, const int ldb,
+                 const double beta, double *C, const int ldc);
+
+/* Fortran interface, column-major, transa/transb are 'N', 'T' or 'C' */
+void dgemm_(const char *transa, const char *transb, const int *m,
+            const int *n, const int *k, const double *alpha, const double *a,
+            const int *lda, const double *b, const int *ldb,
+            const double *beta, double *c, const int *ldc);
+
+#ifdef __cplusplus
+}
+#endif
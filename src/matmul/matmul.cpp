@@ -0,0 +1,131 @@
+#include "matmul.hpp"
+
+#include "memory_layout/page_allocator.hpp"
+#include "reference_kernels/kernel_tiled.hpp"
+#include "reference_kernels/micro_kernel.hpp"
+#include "reference_kernels/naive.hpp"
+#include "reference_kernels/strassen.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+namespace matmul {
+
+namespace {
+
+void verify_arguments(const shape &s, const void *A, const void *B,
+                      const void *C, const strides &st, bool transposed_A,
+                      bool transposed_B) {
+  if (C == nullptr || (s.K > 0 && (A == nullptr || B == nullptr))) {
+    throw util::matrix_multiplication_exception(
+        "gemm: matrix pointer missing");
+  }
+  size_t A_cols = transposed_A ? s.M : s.K;
+  size_t B_cols = transposed_B ? s.K : s.N;
+  if (st.lda < A_cols || st.ldb < B_cols || st.ldc < s.N) {
+    throw util::matrix_multiplication_exception(
+        "gemm: leading dimension smaller than the number of columns");
+  }
+}
+
+// C = beta * C, BLAS semantics: C isn't read if beta is 0
+template <typename T>
+void scale(size_t M, size_t N, T beta, T *C, size_t ldc) {
+#pragma omp parallel for
+  for (size_t i = 0; i < M; i++) {
+    for (size_t j = 0; j < N; j++) {
+      T &c = C[i * ldc + j];
+      c = beta == T(0) ? T(0) : beta * c;
+    }
+  }
+}
+}
+
+std::string to_string(engine e) {
+  switch (e) {
+  case engine::kernel_tiled:
+    return "kernel_tiled";
+  case engine::strassen:
+    return "strassen";
+  case engine::naive:
+    return "naive";
+  }
+  return "unknown";
+}
+
+engine engine_from_string(const std::string &name) {
+  for (engine e : {engine::kernel_tiled, engine::strassen, engine::naive}) {
+    if (name.compare(to_string(e)) == 0) {
+      return e;
+    }
+  }
+  throw util::matrix_multiplication_exception(
+      "unknown gemm engine \"" + name +
+      "\", use kernel_tiled, strassen or naive");
+}
+
+template <typename T> memory_layout::blocking_configuration default_blocking() {
+  memory_layout::blocking_configuration blocking;
+  blocking.set_register_blocking(micro_kernel::default_shape<T>());
+  return blocking;
+}
+
+template <typename T>
+void gemm(engine e, const shape &s, const pointers<T> &ptrs,
+          const strides &st, const options<T> &opt) {
+  verify_arguments(s, ptrs.A, ptrs.B, ptrs.C, st, opt.transposed_A,
+                   opt.transposed_B);
+  if (s.M == 0 || s.N == 0) {
+    return;
+  }
+  if (s.K == 0 || opt.alpha == T(0)) {
+    scale(s.M, s.N, opt.beta, ptrs.C, st.ldc);
+    return;
+  }
+
+  if (e == engine::kernel_tiled) {
+    kernel_tiled::kernel_tiled<T> m(
+        kernel_tiled::pack_A(ptrs.A, s.M, s.K, st.lda, opt.transposed_A,
+                             opt.blocking),
+        kernel_tiled::pack_B(ptrs.B, s.K, s.N, st.ldb, opt.transposed_B,
+                             opt.blocking),
+        1, 0);
+    m.set_schedule(opt.schedule);
+    double duration = 0.0;
+    m.matrix_multiply(opt.alpha, opt.beta, ptrs.C, st.ldc, duration);
+  } else if (e == engine::strassen) {
+    if (opt.strassen_cutoff == 0) {
+      throw util::matrix_multiplication_exception(
+          "gemm: the strassen cutoff has to be larger than 0");
+    }
+    memory_layout::page_vector<T> workspace(
+        strassen::workspace_size(s.M, s.N, s.K, opt.strassen_cutoff));
+    if (opt.alpha == T(1) && opt.beta == T(0)) {
+      strassen::gemm(opt.transposed_A, opt.transposed_B, s.M, s.N, s.K,
+                     ptrs.A, st.lda, ptrs.B, st.ldb, ptrs.C, st.ldc,
+                     opt.strassen_cutoff, workspace.data(), opt.blocking);
+      return;
+    }
+    // the recursion computes the plain product, scaled into C afterwards
+    memory_layout::page_vector<T> product(s.M * s.N);
+    strassen::gemm(opt.transposed_A, opt.transposed_B, s.M, s.N, s.K, ptrs.A,
+                   st.lda, ptrs.B, st.ldb, product.data(), s.N,
+                   opt.strassen_cutoff, workspace.data(), opt.blocking);
+    scale(s.M, s.N, opt.beta, ptrs.C, st.ldc);
+#pragma omp parallel for
+    for (size_t i = 0; i < s.M; i++) {
+      for (size_t j = 0; j < s.N; j++) {
+        ptrs.C[i * st.ldc + j] += opt.alpha * product[i * s.N + j];
+      }
+    }
+  } else {
+    naive_gemm(opt.transposed_A, opt.transposed_B, s.M, s.N, s.K, opt.alpha,
+               ptrs.A, st.lda, ptrs.B, st.ldb, opt.beta, ptrs.C, st.ldc);
+  }
+}
+
+template memory_layout::blocking_configuration default_blocking<double>();
+template memory_layout::blocking_configuration default_blocking<float>();
+template void gemm<double>(engine, const shape &, const pointers<double> &,
+                           const strides &, const options<double> &);
+template void gemm<float>(engine, const shape &, const pointers<float> &,
+                          const strides &, const options<float> &);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+
+namespace matmul {
+
+// In-process interface of libmatmul, needs no HPX runtime and no globals:
+// C = alpha * op(A) * op(B) + beta * C for row-major matrices with leading
+// dimensions, computed by one of the OpenMP engines.
+
+enum class engine {
+  // packed L3/L2/L1 tiling with the micro kernels, the fastest engine
+  kernel_tiled,
+  // Strassen-Winograd with kernel_tiled leaves, fewer flops but a larger error
+  strassen,
+  // triple loop, meant as a reference
+  naive
+};
+
+std::string to_string(engine e);
+
+// "kernel_tiled", "strassen" or "naive", throws
+// util::matrix_multiplication_exception otherwise
+engine engine_from_string(const std::string &name);
+
+// op(A) is M x K, op(B) is K x N and C is M x N
+struct shape {
+  size_t M;
+  size_t N;
+  size_t K;
+};
+
+template <typename T> struct pointers {
+  const T *A;
+  const T *B;
+  T *C;
+};
+
+// leading dimensions (elements between consecutive rows) of the matrices as
+// they are stored
+struct strides {
+  size_t lda;
+  size_t ldb;
+  size_t ldc;
+};
+
+// default blocking with the default register blocking of the element type
+// (micro_kernel::default_shape<T>())
+template <typename T> memory_layout::blocking_configuration default_blocking();
+
+template <typename T> struct options {
+  // A is stored K x M, op(A) = A^T
+  bool transposed_A = false;
+  // B is stored N x K, op(B) = B^T
+  bool transposed_B = false;
+  T alpha = T(1);
+  // C isn't read if beta is 0
+  T beta = T(0);
+  // kernel_tiled and the strassen leaves
+  memory_layout::blocking_configuration blocking = default_blocking<T>();
+  // kernel_tiled only, the strassen leaves use get_tile_schedule()
+  memory_layout::tile_schedule schedule =
+      memory_layout::tile_schedule::static_schedule;
+  // strassen only, see strassen::levels()
+  size_t strassen_cutoff = 2048;
+};
+
+// throws util::matrix_multiplication_exception if a pointer is missing or a
+// leading dimension is too small, memory_layout_exception if the blocking is
+// invalid; instantiated for double and float
+template <typename T>
+void gemm(engine e, const shape &s, const pointers<T> &ptrs,
+          const strides &st, const options<T> &opt = options<T>());
+}
@@ -0,0 +1,543 @@
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/util.hpp>
+#include <hpx/parallel/algorithms/for_loop.hpp>
+#include <hpx/parallel/execution_policy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+#include "reference_kernels/autotuner.hpp"
+#include "reference_kernels/kernel_test.hpp"
+#include "reference_kernels/kernel_tiled.hpp"
+#include "reference_kernels/micro_kernel.hpp"
+#include "reference_kernels/strassen.hpp"
+#include "util/generate_matrix.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+#include "util/results.hpp"
+#include "util/statistics.hpp"
+#include "variants/algorithms.hpp"
+#include "variants/combined.hpp"
+#include "variants/looped.hpp"
+#include "variants/proposal.hpp"
+#include "variants/semi.hpp"
+
+// Runs a sweep over algorithm x N x block-result x block-input x threads in
+// one process. The HPX algorithms are measured while the runtime is up, the
+// OpenMP algorithms after it was shut down (as in matrix_multiply), so that
+// the idle HPX workers don't compete with the OpenMP threads.
+
+boost::program_options::options_description
+    desc_commandline("Usage: matrix_benchmark [options]");
+
+std::vector<std::string> algorithm_names;
+std::vector<std::uint64_t> n_values;
+std::vector<std::uint64_t> block_results;
+std::vector<std::uint64_t> block_inputs;
+// 0 stands for all threads
+std::vector<std::uint64_t> thread_counts;
+bool transposed;
+bool check;
+std::uint64_t verbose;
+std::uint64_t strassen_cutoff;
+std::string tuning_file;
+util::measurement_policy policy;
+util::output_format output_format;
+std::string output_file;
+bool display_help = false;
+
+size_t hpx_threads = 0;
+size_t all_omp_threads = 0;
+// points that were skipped or didn't verify, reported at the end
+size_t skipped_points = 0;
+size_t failed_points = 0;
+
+namespace {
+
+std::vector<std::string> split_list(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream s(list);
+  std::string item;
+  while (std::getline(s, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+std::vector<std::uint64_t> split_numbers(const std::string &option,
+                                         const std::string &list) {
+  std::vector<std::uint64_t> numbers;
+  for (const std::string &item : split_list(list)) {
+    try {
+      numbers.push_back(std::stoull(item));
+    } catch (const std::logic_error &) {
+      throw util::matrix_multiplication_exception(
+          "\"" + item + "\" in --" + option + " is not a number");
+    }
+  }
+  if (numbers.empty()) {
+    throw util::matrix_multiplication_exception("--" + option +
+                                                " needs at least one value");
+  }
+  return numbers;
+}
+
+bool is_hpx_algorithm(const std::string &algorithm) {
+  return algorithm.compare("combined") == 0 ||
+         algorithm.compare("proposal") == 0 ||
+         algorithm.compare("algorithms") == 0 ||
+         algorithm.compare("looped") == 0 || algorithm.compare("semi") == 0;
+}
+
+bool is_omp_algorithm(const std::string &algorithm) {
+  return algorithm.compare("kernel_tiled") == 0 ||
+         algorithm.compare("kernel_test") == 0 ||
+         algorithm.compare("strassen") == 0;
+}
+
+// the other algorithms ignore block-result and block-input, they are
+// measured for the first value only
+bool uses_block_sizes(const std::string &algorithm) {
+  return algorithm.compare("proposal") == 0 ||
+         algorithm.compare("algorithms") == 0 ||
+         algorithm.compare("looped") == 0 || algorithm.compare("semi") == 0;
+}
+
+// same inputs as matrix_multiply: A is random, B the identity, so that the
+// product can be checked against A without a reference multiply; generated
+// block by block with loop
+void create_inputs(std::uint64_t N, std::vector<double> &A,
+                   std::vector<double> &B, const util::block_loop &loop) {
+  A.resize(N * N);
+  util::generate_matrix(util::matrix_pattern::uniform, N, N, A.data(),
+                        util::generator_options(), loop);
+  B.resize(N * N);
+  util::generator_options B_options;
+  B_options.seed = 1;
+  util::generate_matrix(util::matrix_pattern::identity, N, N, B.data(),
+                        B_options, loop);
+}
+
+// OpenMP threads started from an HPX thread would share its core
+void hpx_block_loop(size_t blocks, const std::function<void(size_t)> &body) {
+  hpx::parallel::for_loop(hpx::parallel::par, size_t(0), blocks, body);
+}
+
+memory_layout::blocking_configuration
+tuned_blocking(const std::string &engine, size_t threads, std::uint64_t N) {
+  memory_layout::blocking_configuration blocking;
+  autotuner::tuning_cache cache(tuning_file);
+  if (cache.lookup(autotuner::make_tuning_key(engine, threads, N), blocking) &&
+      verbose >= 1) {
+    std::cout << "using tuned blocking from \"" << tuning_file
+              << "\": " << blocking << std::endl;
+  }
+  return blocking;
+}
+
+// calls f once and returns the time it took
+double time_run(const std::function<void()> &f) {
+  std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+  f();
+  std::chrono::high_resolution_clock::time_point end =
+      std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// every sample is the wall-clock time of a single multiply, the engines are
+// constructed once per point, so that the packing they do in the constructor
+// isn't measured; combined, kernel_tiled and strassen also time their compute
+// phase, inner_samples holds it for every sample (empty for the others)
+void measure_point(const std::string &algorithm, std::uint64_t N,
+                   std::vector<double> &A, std::vector<double> &B,
+                   std::uint64_t block_result, std::uint64_t block_input,
+                   size_t threads, std::vector<double> &C,
+                   util::measurement &m, std::vector<double> &inner_samples,
+                   double &padded_flops, std::string &blocking_string) {
+  padded_flops = 2.0 * static_cast<double>(N) * static_cast<double>(N) *
+                 static_cast<double>(N);
+  blocking_string.clear();
+  inner_samples.clear();
+  std::stringstream blocking_out;
+  if (algorithm.compare("combined") == 0) {
+    memory_layout::blocking_configuration blocking =
+        tuned_blocking("combined", threads, N);
+    blocking_out << blocking;
+    combined::combined engine(N, A, B, transposed, 1, 0, blocking);
+    padded_flops = engine.get_padded_flops();
+    m = util::measure(
+        [&]() {
+          double inner_duration = 0.0;
+          double sample =
+              time_run([&]() { C = engine.matrix_multiply(inner_duration); });
+          inner_samples.push_back(inner_duration);
+          return sample;
+        },
+        policy);
+  } else if (algorithm.compare("proposal") == 0) {
+    proposal::proposal engine(N, A, B, transposed, block_result, block_input,
+                              1, 0);
+    m = util::measure(
+        [&]() {
+          double inner_duration = 0.0;
+          return time_run(
+              [&]() { C = engine.matrix_multiply(inner_duration); });
+        },
+        policy);
+  } else if (algorithm.compare("algorithms") == 0) {
+    algorithms::algorithms engine(N, A, B, block_input, block_result);
+    m = util::measure(
+        [&]() { return time_run([&]() { C = engine.matrix_multiply(); }); },
+        policy);
+  } else if (algorithm.compare("looped") == 0) {
+    looped::looped engine(N, A, B, block_result, block_input);
+    m = util::measure(
+        [&]() { return time_run([&]() { C = engine.matrix_multiply(); }); },
+        policy);
+  } else if (algorithm.compare("semi") == 0) {
+    semi::semi engine(N, A, B, block_result, block_input);
+    m = util::measure(
+        [&]() { return time_run([&]() { C = engine.matrix_multiply(); }); },
+        policy);
+  } else if (algorithm.compare("kernel_tiled") == 0) {
+    memory_layout::blocking_configuration blocking =
+        tuned_blocking("kernel_tiled", threads, N);
+    blocking_out << blocking;
+    kernel_tiled::kernel_tiled<double> engine(N, A, B, transposed, 1, 0,
+                                              blocking);
+    padded_flops = engine.get_padded_flops();
+    // multiplies into the same C every time
+    C.assign(N * N, 0.0);
+    m = util::measure(
+        [&]() {
+          double inner_duration = 0.0;
+          double sample = time_run([&]() {
+            engine.matrix_multiply(1.0, 0.0, C.data(), N, inner_duration);
+          });
+          inner_samples.push_back(inner_duration);
+          return sample;
+        },
+        policy);
+  } else if (algorithm.compare("kernel_test") == 0) {
+    kernel_test::kernel_test engine(N, A, B, transposed, 1, 0);
+    m = util::measure(
+        [&]() { return time_run([&]() { C = engine.matrix_multiply(); }); },
+        policy);
+  } else if (algorithm.compare("strassen") == 0) {
+    memory_layout::blocking_configuration blocking =
+        tuned_blocking("kernel_tiled", threads, N);
+    blocking_out << blocking;
+    strassen::strassen<double> engine(N, A, B, transposed, 1, 0,
+                                      strassen_cutoff, blocking);
+    m = util::measure(
+        [&]() {
+          double inner_duration = 0.0;
+          double sample =
+              time_run([&]() { C = engine.matrix_multiply(inner_duration); });
+          inner_samples.push_back(inner_duration);
+          return sample;
+        },
+        policy);
+  } else {
+    throw util::matrix_multiplication_exception(
+        "\"" + algorithm + "\" is not an algorithm the benchmark supports");
+  }
+  blocking_string = blocking_out.str();
+  // the warmup runs came first
+  if (inner_samples.size() > m.samples.size()) {
+    inner_samples.erase(inner_samples.begin(),
+                        inner_samples.end() - m.samples.size());
+  }
+}
+
+// B is the identity, C has to be A
+std::string verify(const std::vector<double> &A, const std::vector<double> &C) {
+  if (!check) {
+    return "not checked";
+  }
+  bool ok = A.size() == C.size() &&
+            std::equal(A.begin(), A.end(), C.begin(), [](double a, double c) {
+              return std::abs(a - c) < 1E-10;
+            });
+  if (!ok) {
+    failed_points += 1;
+  }
+  return ok ? "passed" : "failed";
+}
+
+void report(const std::string &algorithm, std::uint64_t N,
+            std::uint64_t block_result, std::uint64_t block_input,
+            size_t threads, const util::measurement &m,
+            const std::vector<double> &inner_samples, double padded_flops,
+            const std::string &blocking, const std::string &verification) {
+  double flops = 2.0 * static_cast<double>(N) * static_cast<double>(N) *
+                 static_cast<double>(N);
+  std::cout << "[" << algorithm << ", N = " << N;
+  if (uses_block_sizes(algorithm)) {
+    std::cout << ", block-result = " << block_result
+              << ", block-input = " << block_input;
+  }
+  std::cout << ", threads = " << threads << "] " << m.summary << ", "
+            << (flops / m.summary.mean / 1E9) << " Gflops (mean), "
+            << (flops / m.summary.min / 1E9) << " Gflops (best)";
+  if (!m.converged) {
+    std::cout << ", target precision not reached";
+  }
+  if (check) {
+    std::cout << ", check " << verification;
+  }
+  std::cout << std::endl;
+
+  util::run_record record;
+  record.algorithm = algorithm;
+  record.precision = "double";
+  record.M = N;
+  record.N = N;
+  record.K = N;
+  record.transposed = transposed;
+  record.blocking = blocking;
+  record.block_result = block_result;
+  record.block_input = block_input;
+  record.omp_threads = is_omp_algorithm(algorithm) ? threads : 0;
+  record.hpx_threads = is_hpx_algorithm(algorithm) ? threads : 0;
+  record.repetitions = m.samples.size();
+  // the Gflops of the record are based on the compute phases if the engine
+  // reports them, on the wall-clock samples otherwise
+  record.inner_durations = inner_samples;
+  record.total_duration = 0.0;
+  for (double s : m.samples) {
+    record.total_duration += s;
+  }
+  record.flops = flops;
+  record.padded_flops = padded_flops;
+  record.verification = verification;
+  util::append_record(record, output_format, output_file);
+}
+
+// all points of the sweep for algorithms that satisfy filter, with the thread
+// count applied by set_threads (returns the number of threads used, or 0 if
+// the thread count isn't possible), the inputs are generated with loop
+void sweep(const std::function<bool(const std::string &)> &filter,
+           const std::function<size_t(std::uint64_t)> &set_threads,
+           const util::block_loop &loop) {
+  for (std::uint64_t N : n_values) {
+    bool any = false;
+    for (const std::string &algorithm : algorithm_names) {
+      any = any || filter(algorithm);
+    }
+    if (!any) {
+      continue;
+    }
+    // one allocation per size, shared by all points
+    std::vector<double> A;
+    std::vector<double> B;
+    std::vector<double> C;
+    create_inputs(N, A, B, loop);
+    for (const std::string &algorithm : algorithm_names) {
+      if (!filter(algorithm)) {
+        continue;
+      }
+      if (!transposed && (algorithm.compare("algorithms") == 0 ||
+                          algorithm.compare("looped") == 0 ||
+                          algorithm.compare("semi") == 0)) {
+        std::cout << "skipping \"" << algorithm
+                  << "\", requires B to be transposed" << std::endl;
+        skipped_points += 1;
+        continue;
+      }
+      for (std::uint64_t requested_threads : thread_counts) {
+        size_t threads = set_threads(requested_threads);
+        if (threads == 0) {
+          std::cout << "skipping \"" << algorithm << "\" with "
+                    << requested_threads << " threads, the HPX runtime has "
+                    << hpx_threads << " (use --hpx:threads)" << std::endl;
+          skipped_points += 1;
+          continue;
+        }
+        for (size_t r = 0; r < block_results.size(); r++) {
+          for (size_t i = 0; i < block_inputs.size(); i++) {
+            if (!uses_block_sizes(algorithm) && (r > 0 || i > 0)) {
+              continue;
+            }
+            util::measurement m;
+            std::vector<double> inner_samples;
+            double padded_flops;
+            std::string blocking;
+            measure_point(algorithm, N, A, B, block_results[r],
+                          block_inputs[i], threads, C, m, inner_samples,
+                          padded_flops, blocking);
+            report(algorithm, N, block_results[r], block_inputs[i], threads,
+                   m, inner_samples, padded_flops, blocking, verify(A, C));
+          }
+        }
+      }
+    }
+  }
+}
+}
+
+int hpx_main(boost::program_options::variables_map &vm) {
+  if (vm.count("help")) {
+    display_help = true;
+    std::cout << desc_commandline << std::endl;
+    return hpx::finalize();
+  }
+
+  algorithm_names = split_list(vm["algorithms"].as<std::string>());
+  n_values = split_numbers("n-values", vm["n-values"].as<std::string>());
+  block_results =
+      split_numbers("block-results", vm["block-results"].as<std::string>());
+  block_inputs =
+      split_numbers("block-inputs", vm["block-inputs"].as<std::string>());
+  thread_counts = split_numbers("threads", vm["threads"].as<std::string>());
+  transposed = vm["transposed"].as<bool>();
+  check = vm["check"].as<bool>();
+  verbose = vm["verbose"].as<std::uint64_t>();
+  strassen_cutoff = vm["strassen-cutoff"].as<std::uint64_t>();
+  tuning_file = vm["tuning-file"].as<std::string>();
+  policy.warmup = vm["warmup"].as<std::uint64_t>();
+  policy.min_samples = vm["min-samples"].as<std::uint64_t>();
+  policy.max_samples = vm["max-samples"].as<std::uint64_t>();
+  policy.relative_precision = vm["relative-precision"].as<double>();
+  policy.confidence = vm["confidence"].as<double>();
+  policy.max_seconds = vm["max-seconds"].as<double>();
+  output_format =
+      util::output_format_from_string(vm["output-format"].as<std::string>());
+  output_file = vm["output-file"].as<std::string>();
+  micro_kernel::set_isa(vm["isa"].as<std::string>());
+  memory_layout::set_tile_schedule(memory_layout::tile_schedule_from_string(
+      vm["schedule"].as<std::string>()));
+
+  for (const std::string &algorithm : algorithm_names) {
+    if (!is_hpx_algorithm(algorithm) && !is_omp_algorithm(algorithm)) {
+      throw util::matrix_multiplication_exception(
+          "\"" + algorithm + "\" is not an algorithm the benchmark supports");
+    }
+  }
+
+  hpx_threads = hpx::get_os_thread_count();
+  // the HPX runtime can't be resized, only its own thread count is measured
+  sweep(is_hpx_algorithm,
+        [](std::uint64_t threads) -> size_t {
+          return threads == 0 || threads == hpx_threads ? hpx_threads : 0;
+        },
+        hpx_block_loop);
+
+  return hpx::finalize(); // Handles HPX shutdown
+}
+
+int main(int argc, char *argv[]) {
+  desc_commandline.add_options()(
+      "algorithms",
+      boost::program_options::value<std::string>()->default_value(
+          "combined,kernel_tiled"),
+      "comma-separated list of algorithms: combined, proposal, algorithms, "
+      "looped, semi (HPX), kernel_tiled, kernel_test, strassen (OpenMP)")(
+      "n-values",
+      boost::program_options::value<std::string>()->default_value(
+          "512,1024,2048"),
+      "comma-separated list of matrix sizes")(
+      "block-results",
+      boost::program_options::value<std::string>()->default_value("128"),
+      "comma-separated list of block-result values (proposal, algorithms, "
+      "looped, semi)")(
+      "block-inputs",
+      boost::program_options::value<std::string>()->default_value("128"),
+      "comma-separated list of block-input values (proposal, algorithms, "
+      "looped, semi)")(
+      "threads",
+      boost::program_options::value<std::string>()->default_value("0"),
+      "comma-separated list of thread counts, 0 for all threads; applies to "
+      "the OpenMP algorithms, the HPX algorithms run with --hpx:threads and "
+      "skip other values")(
+      "transposed", boost::program_options::value<bool>()->default_value(true),
+      "use a transposed matrix for B")(
+      "warmup",
+      boost::program_options::value<std::uint64_t>()->default_value(1),
+      "runs per point that aren't measured")(
+      "min-samples",
+      boost::program_options::value<std::uint64_t>()->default_value(3),
+      "measured runs per point at least")(
+      "max-samples",
+      boost::program_options::value<std::uint64_t>()->default_value(30),
+      "measured runs per point at most")(
+      "relative-precision",
+      boost::program_options::value<double>()->default_value(0.02),
+      "a point is done once the confidence interval of the mean duration is "
+      "within this fraction of the mean")(
+      "confidence",
+      boost::program_options::value<double>()->default_value(0.95),
+      "confidence level of the interval")(
+      "max-seconds",
+      boost::program_options::value<double>()->default_value(60.0),
+      "time budget of the measured runs per point, stops a point early")(
+      "check", boost::program_options::value<bool>()->default_value(true),
+      "compare the product of every point with A (B is the identity)")(
+      "verbose", boost::program_options::value<uint64_t>()->default_value(0),
+      "set to 1 to print the tuned blockings used")(
+      "isa",
+      boost::program_options::value<std::string>()->default_value("auto"),
+      "instruction set of the micro kernels, one of auto, sse2, avx, avx2")(
+      "schedule",
+      boost::program_options::value<std::string>()->default_value("static"),
+      "kernel_tiled and combined: static or stealing")(
+      "strassen-cutoff",
+      boost::program_options::value<std::uint64_t>()->default_value(2048),
+      "strassen: largest leaf dimension")(
+      "tuning-file",
+      boost::program_options::value<std::string>()->default_value(
+          "matrix_multiply_tuning.txt"),
+      "combined, kernel_tiled and strassen use the tuned blockings of this "
+      "file, the default blocking otherwise")(
+      "output-format",
+      boost::program_options::value<std::string>()->default_value("none"),
+      "write a record per point: none, json (one object per line) or csv, "
+      "the total duration is the sum of the wall-clock samples, the inner "
+      "durations are the compute phases of the samples (combined, "
+      "kernel_tiled and strassen)")(
+      "output-file",
+      boost::program_options::value<std::string>()->default_value(""),
+      "file the records are appended to, stdout if empty")(
+      "help", "display help");
+
+  // used for --threads=0, omp_set_num_threads() changes what is returned
+  all_omp_threads = omp_get_max_threads();
+
+  // Initialize and run HPX
+  int return_value = hpx::init(desc_commandline, argc, argv);
+  if (return_value != 0 || display_help) {
+    return return_value;
+  }
+
+  sweep(is_omp_algorithm,
+        [](std::uint64_t threads) -> size_t {
+          size_t used = threads == 0 ? all_omp_threads : threads;
+          omp_set_num_threads(static_cast<int>(used));
+          return used;
+        },
+        util::openmp_block_loop);
+  omp_set_num_threads(static_cast<int>(all_omp_threads));
+
+  if (skipped_points > 0) {
+    std::cout << skipped_points << " points skipped" << std::endl;
+  }
+  if (failed_points > 0) {
+    std::cout << "error: " << failed_points << " points failed the check"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -3,19 +3,40 @@
 #include <hpx/include/async.hpp>
 #include <hpx/include/components.hpp>
 #include <hpx/include/util.hpp>
+#include <hpx/parallel/algorithms/for_loop.hpp>
+#include <hpx/parallel/execution_policy.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <iostream>
-#include <random>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include <omp.h>
 
 #include <boost/format.hpp>
 
+#include "matmul/matmul.hpp"
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/numa.hpp"
+#include "memory_layout/page_allocator.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+#include "reference_kernels/autotuner.hpp"
 #include "reference_kernels/kernel_test.hpp"
 #include "reference_kernels/kernel_tiled.hpp"
-#include "reference_kernels/naive.hpp"
+#include "reference_kernels/micro_kernel.hpp"
+#include "reference_kernels/out_of_core.hpp"
+#include "reference_kernels/roofline.hpp"
+#include "reference_kernels/strassen.hpp"
+#include "util/generate_matrix.hpp"
+#include "util/matrix_file.hpp"
 #include "util/matrix_multiplication_exception.hpp"
+#include "util/perf_counters.hpp"
+#include "util/results.hpp"
 #include "util/util.hpp"
 #include "variants/algorithms.hpp"
 #include "variants/combined.hpp"
@@ -54,6 +75,96 @@ std::uint64_t min_work_size;
 std::uint64_t max_work_difference;
 double max_relative_work_difference;
 
+// kernel_tiled and combined only
+memory_layout::blocking_configuration blocking;
+bool blocking_from_command_line;
+bool autotune;
+std::string tuning_file;
+
+// kernel_tiled only, "double" or "float"
+std::string precision;
+// kernel_tiled only, bind the OpenMP threads socket by socket
+bool numa_bind;
+
+// strassen only, products with a dimension up to the cutoff are leaves
+std::uint64_t strassen_cutoff;
+
+// out_of_core only, MB the panel buffers may take
+std::uint64_t memory_budget;
+
+// machine-readable results, written by the root node after the check
+util::output_format output_format;
+std::string output_file;
+// per repetition, only filled by algorithms that measure them
+std::vector<double> inner_durations;
+// flops including the padding, 2 N^3 for algorithms without padding
+double padded_flops = 0.0;
+size_t hpx_threads = 0;
+
+// generated inputs, B is generated with seed + 1
+util::matrix_pattern pattern_a;
+util::matrix_pattern pattern_b;
+std::uint64_t generator_seed;
+
+// memory-mapped inputs and output, N is taken from the input files
+std::string input_a;
+std::string input_b;
+std::string output_c;
+std::unique_ptr<util::mapped_matrix> A_file;
+std::unique_ptr<util::mapped_matrix> B_file;
+std::unique_ptr<util::mapped_matrix> C_file;
+// the operands as multiplied: A and B, or for kernel_tiled the mapped files,
+// B_data is stored transposed if B_data_transposed
+const double *A_data = nullptr;
+const double *B_data = nullptr;
+bool B_data_transposed;
+
+// loads the blocking for the current machine from the tuning file or runs the
+// autotuner, a blocking given on the command line takes precedence
+void select_blocking(
+    const std::string &engine, size_t threads,
+    std::function<double(const memory_layout::blocking_configuration &)>
+        benchmark,
+    const std::vector<std::pair<size_t, size_t>> &register_shapes =
+        micro_kernel::available_shapes()) {
+  autotuner::tuning_key key = autotuner::make_tuning_key(engine, threads, N);
+  autotuner::tuning_cache cache(tuning_file);
+  if (autotune) {
+    autotuner::autotuner tuner(benchmark, register_shapes, verbose);
+    double gflops;
+    blocking = tuner.tune(blocking, gflops);
+    cache.store(key, blocking, gflops);
+  } else if (!blocking_from_command_line && cache.lookup(key, blocking)) {
+    std::cout << "using tuned blocking from \"" << tuning_file
+              << "\": " << blocking << std::endl;
+  }
+}
+
+// input files have to hold square matrices
+std::unique_ptr<util::mapped_matrix>
+map_input(const std::string &file, const std::string &option,
+          util::access_pattern access) {
+  std::unique_ptr<util::mapped_matrix> m(
+      new util::mapped_matrix(file, access));
+  if (m->get_rows() != m->get_cols()) {
+    throw util::matrix_multiplication_exception(
+        "--" + option + ": \"" + file + "\" doesn't hold a square matrix");
+  }
+  return m;
+}
+
+// the generators run on the HPX worker threads, OpenMP threads started from an
+// HPX thread would share its core
+void hpx_block_loop(size_t blocks, const std::function<void(size_t)> &body) {
+  hpx::parallel::for_loop(hpx::parallel::par, size_t(0), blocks, body);
+}
+
+double gflops_square(double duration_single_run) {
+  double flops = 2 * static_cast<double>(N) * static_cast<double>(N) *
+                 static_cast<double>(N);
+  return flops / 1E9 / duration_single_run;
+}
+
 int hpx_main(boost::program_options::variables_map &vm) {
 
   std::cout << "in HPX main" << std::endl;
@@ -73,6 +184,67 @@ int hpx_main(boost::program_options::variables_map &vm) {
   max_relative_work_difference =
       vm["max-relative-work-difference"].as<double>();
 
+  blocking.L3_X = vm["l3-x"].as<std::uint64_t>();
+  blocking.L3_Y = vm["l3-y"].as<std::uint64_t>();
+  blocking.L3_K_STEP = vm["l3-k-step"].as<std::uint64_t>();
+  blocking.L2_X = vm["l2-x"].as<std::uint64_t>();
+  blocking.L2_Y = vm["l2-y"].as<std::uint64_t>();
+  blocking.L2_K_STEP = vm["l2-k-step"].as<std::uint64_t>();
+  blocking.L1_X = vm["l1-x"].as<std::uint64_t>();
+  blocking.L1_Y = vm["l1-y"].as<std::uint64_t>();
+  blocking.L1_K_STEP = vm["l1-k-step"].as<std::uint64_t>();
+  precision = vm["precision"].as<std::string>();
+  if (precision.compare("double") != 0 && precision.compare("float") != 0) {
+    throw util::matrix_multiplication_exception(
+        "precision has to be \"double\" or \"float\"");
+  }
+  if (precision.compare("float") == 0 &&
+      algorithm.compare("kernel_tiled") != 0) {
+    throw util::matrix_multiplication_exception(
+        "single precision is only supported by algorithm \"kernel_tiled\"");
+  }
+  if (precision.compare("float") == 0 && vm["micro-kernel"].defaulted()) {
+    // twice as many float elements fit into a vector register
+    blocking.set_register_blocking(micro_kernel::default_shape<float>());
+  } else {
+    blocking.set_register_blocking(vm["micro-kernel"].as<std::string>());
+  }
+  micro_kernel::set_isa(vm["isa"].as<std::string>());
+  if (verbose >= 1) {
+    std::cout << "micro kernel instruction set: "
+              << micro_kernel::to_string(micro_kernel::get_isa()) << std::endl;
+  }
+  blocking_from_command_line = false;
+  for (const char *level :
+       {"l3-x", "l3-y", "l3-k-step", "l2-x", "l2-y", "l2-k-step", "l1-x",
+        "l1-y", "l1-k-step", "micro-kernel"}) {
+    if (!vm[level].defaulted()) {
+      blocking_from_command_line = true;
+    }
+  }
+  autotune = vm["autotune"].as<bool>();
+  strassen_cutoff = vm["strassen-cutoff"].as<std::uint64_t>();
+  memory_budget = vm["memory-budget"].as<std::uint64_t>();
+  numa_bind = vm["numa-bind"].as<bool>();
+  memory_layout::set_huge_pages(vm["huge-pages"].as<bool>());
+  util::set_perf_counters(vm["perf-counters"].as<bool>());
+  roofline::set_reporting(vm["roofline"].as<bool>());
+  memory_layout::set_tile_schedule(memory_layout::tile_schedule_from_string(
+      vm["schedule"].as<std::string>()));
+  tuning_file = vm["tuning-file"].as<std::string>();
+  output_format =
+      util::output_format_from_string(vm["output-format"].as<std::string>());
+  output_file = vm["output-file"].as<std::string>();
+  hpx_threads = hpx::get_os_thread_count();
+  input_a = vm["input-a"].as<std::string>();
+  input_b = vm["input-b"].as<std::string>();
+  output_c = vm["output-c"].as<std::string>();
+  pattern_a = util::matrix_pattern_from_string(
+      vm["generate-a"].as<std::string>());
+  pattern_b = util::matrix_pattern_from_string(
+      vm["generate-b"].as<std::string>());
+  generator_seed = vm["seed"].as<std::uint64_t>();
+
   if (vm.count("help")) {
     std::cout << desc_commandline << std::endl;
     return hpx::finalize();
@@ -80,49 +252,93 @@ int hpx_main(boost::program_options::variables_map &vm) {
 
   is_root_node = hpx::find_here() == hpx::find_root_locality();
 
-  // create matrices A, B
-  std::default_random_engine generator;
-  std::uniform_real_distribution<double> distribution(0.0, 1.0);
-  auto myRand = std::bind(distribution, generator);
-
-  A.resize(N * N);
-  std::generate(A.begin(), A.end(), myRand);
+  // out_of_core streams the inputs panel by panel
+  bool streamed = algorithm.compare("out_of_core") == 0;
+  if (streamed && (input_a.empty() || input_b.empty() || output_c.empty())) {
+    throw util::matrix_multiplication_exception(
+        "algorithm \"out_of_core\" needs --input-a, --input-b and "
+        "--output-c");
+  }
+  util::access_pattern access =
+      streamed ? util::access_pattern::streamed : util::access_pattern::whole;
 
-  if (verbose >= 2) {
-    hpx::cout << "matrix A:" << std::endl << hpx::flush;
-    print_matrix(N, A);
+  if (!input_a.empty()) {
+    A_file = map_input(input_a, "input-a", access);
+    N = A_file->get_rows();
   }
+  if (!input_b.empty()) {
+    B_file = map_input(input_b, "input-b", access);
+    if (A_file && B_file->get_rows() != N) {
+      throw util::matrix_multiplication_exception(
+          "--input-a and --input-b differ in size");
+    }
+    N = B_file->get_rows();
+  }
+  // kernel_tiled packs directly from the page cache, out_of_core reads the
+  // files itself, the other algorithms get copies
+  bool pack_from_files = (algorithm.compare("kernel_tiled") == 0 &&
+                          precision.compare("double") == 0) ||
+                         streamed;
 
-  B.resize(N * N);
+  // create matrices A, B
+  if (A_file && pack_from_files) {
+    A_data = A_file->data();
+  } else {
+    if (A_file) {
+      A.assign(A_file->data(), A_file->data() + N * N);
+    } else {
+      A.resize(N * N);
+      util::generator_options options;
+      options.seed = generator_seed;
+      util::generate_matrix(pattern_a, N, N, A.data(), options,
+                            hpx_block_loop);
+    }
+    A_data = A.data();
 
-  if (!transposed) {
-    for (uint64_t i = 0; i < N; i++) {
-      for (uint64_t j = 0; j < N; j++) {
-        if (i == j) {
-          B.at(i * N + j) = 1.0;
-        } else {
-          B.at(i * N + j) = 0.0;
-        }
-      }
+    if (verbose >= 2) {
+      hpx::cout << "matrix A:" << std::endl << hpx::flush;
+      print_matrix(N, A);
     }
+  }
+
+  B_data_transposed = transposed;
+  if (B_file && pack_from_files) {
+    // the file holds B, the packing doesn't transpose
+    B_data = B_file->data();
+    B_data_transposed = false;
   } else {
-    for (uint64_t i = 0; i < N; i++) {
-      for (uint64_t j = 0; j < N; j++) {
-        if (i == j) {
-          B.at(j * N + i) = 1.0;
-        } else {
-          B.at(j * N + i) = 0.0;
+    B.resize(N * N);
+
+    if (B_file) {
+      // the file holds B, the algorithms expect B^T if transposed
+      const double *B_org = B_file->data();
+      for (uint64_t i = 0; i < N; i++) {
+        for (uint64_t j = 0; j < N; j++) {
+          if (!transposed) {
+            B[i * N + j] = B_org[i * N + j];
+          } else {
+            B[j * N + i] = B_org[i * N + j];
+          }
         }
       }
+    } else {
+      // stored transposed if transposed
+      util::generator_options options;
+      options.seed = generator_seed + 1;
+      options.transposed = transposed;
+      util::generate_matrix(pattern_b, N, N, B.data(), options,
+                            hpx_block_loop);
     }
-  }
 
-  if (verbose >= 2) {
-    hpx::cout << "matrix B:" << std::endl << hpx::flush;
-    if (!transposed) {
-      print_matrix(N, B);
-    } else {
-      print_matrix_transposed(N, B);
+    B_data = B.data();
+
+    if (verbose >= 2) {
+      hpx::cout << "matrix B:" << std::endl << hpx::flush;
+      if (!transposed) {
+        print_matrix(N, B);
+      } else {
+        print_matrix_transposed(N, B);
+      }
     }
   }
 
@@ -207,13 +423,19 @@ int hpx_main(boost::program_options::variables_map &vm) {
     semi::semi m(N, A, B, block_result, block_input);
     C = m.matrix_multiply();
   } else if (algorithm.compare("combined") == 0) {
-    if (transposed) {
-      throw util::matrix_multiplication_exception(
-          "algorithm \"combined\" doens't allow B to be transposed");
-    }
-    combined::combined m(N, A, B, repetitions, verbose);
+    select_blocking("combined", hpx::get_os_thread_count(),
+                    [](const memory_layout::blocking_configuration &b) {
+                      combined::combined m(N, A, B, transposed, 1, 0, b);
+                      double inner_duration;
+                      m.matrix_multiply(inner_duration);
+                      return gflops_square(inner_duration);
+                    });
+    combined::combined m(N, A, B, transposed, repetitions, verbose,
+                         blocking);
     double inner_duration;
     C = m.matrix_multiply(inner_duration);
+    inner_durations = m.get_repetition_durations();
+    padded_flops = m.get_padded_flops();
   } else if (algorithm.compare("proposal") == 0) {
     proposal::proposal m(N, A, B, transposed, block_result, block_input,
                          repetitions, verbose);
@@ -271,7 +493,7 @@ int main(int argc, char *argv[]) {
       "algorithm",
       boost::program_options::value<std::string>()->default_value("single"),
       "select algorithm: single, pseudodynamic, algorithms, looped, semi, "
-      "combined, kernel_test, kernel_tiled")(
+      "combined, kernel_test, kernel_tiled, strassen, out_of_core")(
       "min-work-size",
       boost::program_options::value<std::uint64_t>()->default_value(256),
       "pseudodynamic algorithm: minimum work package size per node")(
@@ -282,7 +504,131 @@ int main(int argc, char *argv[]) {
       "max-relative-work-difference",
       boost::program_options::value<double>()->default_value(0.05),
       "pseudodynamic algorithm: maximum relative tolerated load inbalance "
-      "in matrix components assigned, in percent")("help", "display help");
+      "in matrix components assigned, in percent")(
+      "l3-x",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L3_X),
+      "kernel_tiled and combined: L3 blocking in x direction (rows of A)")(
+      "l3-y",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L3_Y),
+      "kernel_tiled and combined: L3 blocking in y direction (columns of B)")(
+      "l3-k-step",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L3_K_STEP),
+      "kernel_tiled and combined: L3 blocking in k direction")(
+      "l2-x",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L2_X),
+      "kernel_tiled and combined: L2 blocking in x direction, has to divide "
+      "l3-x")(
+      "l2-y",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L2_Y),
+      "kernel_tiled and combined: L2 blocking in y direction, has to divide "
+      "l3-y")(
+      "l2-k-step",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L2_K_STEP),
+      "kernel_tiled and combined: L2 blocking in k direction, has to divide "
+      "l3-k-step")(
+      "l1-x",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L1_X),
+      "kernel_tiled and combined: L1 blocking in x direction, has to divide "
+      "l2-x and be a multiple of the register blocking")(
+      "l1-y",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L1_Y),
+      "kernel_tiled and combined: L1 blocking in y direction, has to divide "
+      "l2-y and be a multiple of the register blocking")(
+      "l1-k-step",
+      boost::program_options::value<std::uint64_t>()->default_value(
+          blocking.L1_K_STEP),
+      "kernel_tiled and combined: depth of the packed tiles, has to divide "
+      "l2-k-step (the micro kernel runs over a whole l2-k-step block)")(
+      "micro-kernel",
+      boost::program_options::value<std::string>()->default_value("5x8"),
+      "kernel_tiled and combined: register blocking of the micro kernel, one "
+      "of 5x8, 4x12, 6x8, 8x4 (depending on the vector width), for float one "
+      "of 5x16 (default), 4x24, 6x16, 8x8")(
+      "precision",
+      boost::program_options::value<std::string>()->default_value("double"),
+      "kernel_tiled: element type, double or float (vectors of twice as many "
+      "elements)")(
+      "isa",
+      boost::program_options::value<std::string>()->default_value("auto"),
+      "kernel_tiled and combined: instruction set of the micro kernel, one "
+      "of auto (detected via cpuid), sse2, avx, avx2")(
+      "numa-bind",
+      boost::program_options::value<bool>()->default_value(false),
+      "kernel_tiled and kernel_test: bind the OpenMP threads to the NUMA nodes "
+      "in order, so that the packed buffers are distributed over the sockets "
+      "(for the HPX algorithms use --hpx:bind=numa-balanced)")(
+      "huge-pages",
+      boost::program_options::value<bool>()->default_value(false),
+      "kernel_tiled, combined and kernel_test: back the packed buffers with "
+      "huge pages (MAP_HUGETLB, else transparent huge pages, else small "
+      "pages), the backing obtained is shown with --verbose=1")(
+      "perf-counters",
+      boost::program_options::value<bool>()->default_value(false),
+      "kernel_tiled, combined, kernel_test and strassen: print hardware "
+      "counters (cycles, instructions, L1D/LLC/dTLB misses, FP ops) of the "
+      "packing and of every compute run, needs perf_event_open access")(
+      "roofline",
+      boost::program_options::value<bool>()->default_value(true),
+      "report the Gflops as a fraction of the measured compute peak and the "
+      "packing as a fraction of the measured bandwidth (calibrated after the "
+      "multiply, about one second)")(
+      "schedule",
+      boost::program_options::value<std::string>()->default_value("static"),
+      "kernel_tiled and combined: distribution of the L3 tiles over the "
+      "threads, static (contiguous chunks) or stealing (same chunks, idle "
+      "threads steal tiles from the others)")(
+      "strassen-cutoff",
+      boost::program_options::value<std::uint64_t>()->default_value(2048),
+      "strassen: recursion stops once the smallest dimension of a product is "
+      "at most the cutoff, the leaves are computed by kernel_tiled")(
+      "memory-budget",
+      boost::program_options::value<std::uint64_t>()->default_value(4096),
+      "out_of_core: MB the panels of A and B may take, the larger the A "
+      "panels, the less often B is read from disk")(
+      "autotune", boost::program_options::value<bool>()->default_value(false),
+      "kernel_tiled and combined: search the best blocking for this machine "
+      "and matrix size and store it in the tuning file")(
+      "tuning-file",
+      boost::program_options::value<std::string>()->default_value(
+          "matrix_multiply_tuning.txt"),
+      "kernel_tiled and combined: file with tuned blockings, used "
+      "automatically if no blocking is given on the command line")(
+      "output-format",
+      boost::program_options::value<std::string>()->default_value("none"),
+      "write the run as a machine-readable record after the check: none, "
+      "json (one object per line) or csv (header for new files)")(
+      "output-file",
+      boost::program_options::value<std::string>()->default_value(""),
+      "file the record is appended to, stdout if empty")(
+      "generate-a",
+      boost::program_options::value<std::string>()->default_value("uniform"),
+      "pattern of the generated A: uniform, normal, identity, diagonal or "
+      "enumerating, generated in parallel, the same for any thread count")(
+      "generate-b",
+      boost::program_options::value<std::string>()->default_value("identity"),
+      "pattern of the generated B, as generate-a")(
+      "seed", boost::program_options::value<std::uint64_t>()->default_value(0),
+      "seed of the generated A, B uses seed + 1")(
+      "input-a",
+      boost::program_options::value<std::string>()->default_value(""),
+      "read A from a memory-mapped file instead of generating it: .npy "
+      "(float64, C order) or raw little-endian doubles, sets the n-value")(
+      "input-b",
+      boost::program_options::value<std::string>()->default_value(""),
+      "read B (not transposed) from a memory-mapped file instead of "
+      "generating it, same formats as input-a")(
+      "output-c",
+      boost::program_options::value<std::string>()->default_value(""),
+      "write C to a memory-mapped .npy or raw file")(
+      "help", "display help");
 
   // std::cout << "parsing" << std::endl;
   // boost::program_options::variables_map vm;
@@ -317,12 +663,59 @@ int main(int argc, char *argv[]) {
   int return_value = hpx::init(desc_commandline, argc, argv);
   std::cout << "after HPX" << std::endl;
 
+  if (non_hpx_algorithm && numa_bind) {
+    // before anything is packed, so that the packing threads place the pages
+    memory_layout::numa::bind_openmp_threads();
+    if (verbose >= 1) {
+      std::cout << "bound OpenMP threads to "
+                << memory_layout::numa::node_count() << " NUMA nodes"
+                << std::endl;
+    }
+  }
+
   if (algorithm.compare("kernel_test") == 0) {
     hpx::util::high_resolution_timer t;
     kernel_test::kernel_test m(N, A, B, transposed, repetitions, verbose);
     C = m.matrix_multiply();
 
     duration = t.elapsed();
+    std::cout << "non-HPX [N = " << N << "] total time: " << duration << "s"
+              << std::endl;
+    std::cout << "non-HPX [N = " << N
+              << "] average time per run: " << (duration / repetitions)
+              << "s (repetitions = " << repetitions << ")" << std::endl;
+
+    if (verbose >= 2) {
+      std::cout << "non-HPX matrix C:" << std::endl;
+      print_matrix_host(N, C);
+    }
+  } else if (algorithm.compare("kernel_tiled") == 0 &&
+             precision.compare("float") == 0) {
+    // the inputs are converted, so that the check compares with the product
+    // of the rounded matrices (A and B are copies for float, never the files)
+    std::transform(A.begin(), A.end(), A.begin(),
+                   [](double a) { return static_cast<float>(a); });
+    std::transform(B.begin(), B.end(), B.begin(),
+                   [](double b) { return static_cast<float>(b); });
+    std::vector<float> A_float(A.begin(), A.end());
+    std::vector<float> B_float(B.begin(), B.end());
+    select_blocking("kernel_tiled_float", omp_get_max_threads(),
+                    [&A_float, &B_float](
+                        const memory_layout::blocking_configuration &b) {
+                      kernel_tiled::kernel_tiled<float> m(
+                          N, A_float, B_float, transposed, 1, 0, b);
+                      double inner_duration = 0.0;
+                      m.matrix_multiply(inner_duration);
+                      return gflops_square(inner_duration);
+                    },
+                    micro_kernel::available_shapes<float>());
+    kernel_tiled::kernel_tiled<float> m(N, A_float, B_float, transposed,
+                                        repetitions, verbose, blocking);
+    std::vector<float> C_float = m.matrix_multiply(duration);
+    C.assign(C_float.begin(), C_float.end());
+    inner_durations = m.get_repetition_durations();
+    padded_flops = m.get_padded_flops();
+
     std::cout << "non-HPX [N = " << N << "] total time: " << duration << "s"
               << std::endl;
     std::cout << "non-HPX [N = " << N
@@ -334,8 +727,51 @@ int main(int argc, char *argv[]) {
       print_matrix_host(N, C);
     }
   } else if (algorithm.compare("kernel_tiled") == 0) {
-    kernel_tiled::kernel_tiled m(N, A, B, transposed, repetitions, verbose);
+    // A_data and B_data may be mapped files
+    select_blocking("kernel_tiled", omp_get_max_threads(),
+                    [](const memory_layout::blocking_configuration &b) {
+                      kernel_tiled::kernel_tiled<double> m(
+                          N, A_data, B_data, B_data_transposed, 1, 0, b);
+                      double inner_duration = 0.0;
+                      m.matrix_multiply(inner_duration);
+                      return gflops_square(inner_duration);
+                    });
+    kernel_tiled::kernel_tiled<double> m(N, A_data, B_data, B_data_transposed,
+                                         repetitions, verbose, blocking);
+    if (!output_c.empty()) {
+      // written through the mapping, no copy of C
+      C_file.reset(new util::mapped_matrix(output_c, N, N));
+      m.matrix_multiply(C_file->data(), N, duration);
+    } else {
+      C = m.matrix_multiply(duration);
+    }
+    inner_durations = m.get_repetition_durations();
+    padded_flops = m.get_padded_flops();
+
+    std::cout << "non-HPX [N = " << N << "] total time: " << duration << "s"
+              << std::endl;
+    std::cout << "non-HPX [N = " << N
+              << "] average time per run: " << (duration / repetitions)
+              << "s (repetitions = " << repetitions << ")" << std::endl;
+
+    if (verbose >= 2 && !C_file) {
+      std::cout << "non-HPX matrix C:" << std::endl;
+      print_matrix_host(N, C);
+    }
+  } else if (algorithm.compare("strassen") == 0) {
+    // the leaves use the blocking of kernel_tiled
+    select_blocking("kernel_tiled", omp_get_max_threads(),
+                    [](const memory_layout::blocking_configuration &b) {
+                      kernel_tiled::kernel_tiled<double> m(
+                          N, A, B, transposed, 1, 0, b);
+                      double inner_duration = 0.0;
+                      m.matrix_multiply(inner_duration);
+                      return gflops_square(inner_duration);
+                    });
+    strassen::strassen<double> m(N, A, B, transposed, repetitions, verbose,
+                                 strassen_cutoff, blocking);
     C = m.matrix_multiply(duration);
+    inner_durations = m.get_repetition_durations();
 
     std::cout << "non-HPX [N = " << N << "] total time: " << duration << "s"
               << std::endl;
@@ -347,6 +783,21 @@ int main(int argc, char *argv[]) {
       std::cout << "non-HPX matrix C:" << std::endl;
       print_matrix_host(N, C);
     }
+  } else if (algorithm.compare("out_of_core") == 0) {
+    // the panels are read from the mapped files, C is written back while it
+    // is computed
+    C_file.reset(new util::mapped_matrix(output_c, N, N));
+    out_of_core::out_of_core m(*A_file, *B_file, false, *C_file, repetitions,
+                               verbose, memory_budget * 1024 * 1024,
+                               blocking);
+    m.matrix_multiply(duration);
+    inner_durations = m.get_repetition_durations();
+
+    std::cout << "non-HPX [N = " << N << "] total time: " << duration << "s"
+              << std::endl;
+    std::cout << "non-HPX [N = " << N
+              << "] average time per run: " << (duration / repetitions)
+              << "s (repetitions = " << repetitions << ")" << std::endl;
   } else {
     if (non_hpx_algorithm) {
       std::cout << "\"" << algorithm << "\" not a valid algorithm" << std::endl;
@@ -356,6 +807,12 @@ int main(int argc, char *argv[]) {
 
   if (is_root_node) {
 
+    if (!output_c.empty() && !C_file) {
+      C_file.reset(new util::mapped_matrix(output_c, N, N));
+      std::copy(C.begin(), C.end(), C_file->data());
+    }
+    const double *C_data = C_file ? C_file->data() : C.data();
+
     double flops = 2 * static_cast<double>(N) * static_cast<double>(N) *
                    static_cast<double>(N);
     double gflop = flops / 1E9;
@@ -363,6 +820,14 @@ int main(int argc, char *argv[]) {
               << "] performance: " << (repetitions * gflop / duration)
               << "Gflops (average across repetitions)" << std::endl;
 
+    // hpx is shut down, the calibration has the cores for itself
+    roofline::record_compute("[N = " + std::to_string(N) + "] " + algorithm,
+                             repetitions * gflop / duration,
+                             precision.compare("float") == 0);
+    roofline::print_report();
+
+    std::string verification = "not checked";
+
     // hpx should now be shut down, can now use CPU for (fast) checking
 
     if (check) {
@@ -371,12 +836,12 @@ int main(int argc, char *argv[]) {
                   << std::endl;
       }
       hpx::util::high_resolution_timer t2;
-      std::vector<double> Cref;
-      if (!transposed) {
-        Cref = naive_matrix_multiply(N, A, B);
-      } else {
-        Cref = naive_matrix_multiply_transposed(N, A, B);
-      }
+      std::vector<double> Cref(N * N);
+      matmul::options<double> reference_options;
+      reference_options.transposed_B = B_data_transposed;
+      matmul::gemm(matmul::engine::naive, {N, N, N},
+                   {A_data, B_data, Cref.data()}, {N, N, N},
+                   reference_options);
       char const *fmt = "naive matMult took %1% [s]";
       double duration_reference = t2.elapsed();
       std::cout << (boost::format(fmt) % duration_reference) << std::endl;
@@ -390,27 +855,31 @@ int main(int argc, char *argv[]) {
       }
 
       // compare solutions
-      bool ok = std::equal(C.begin(), C.end(), Cref.begin(), Cref.end(),
-                           [](double first, double second) {
-                             //							std::cout
-                             //<<
-                             //"first:
-                             //"
-                             //<<
-                             // first
-                             //<<
-                             //"
-                             // second: " << second << std::endl;
-                             if (std::abs(first - second) < 1E-10) {
-                               //								std::cout
-                               //<< "true" << std::endl;
-                               return true;
-                             } else {
-                               //								std::cout
-                               //<< "false" << std::endl;
-                               return false;
-                             }
-                           });
+      // single precision: the products of the rounded inputs are accumulated
+      // in float, the error of an element is at most about
+      // K * eps * (|A| |B|)_ij, so the bound scales with the inputs and K
+      std::vector<double> error_bound(N * N, 1E-10);
+      if (precision.compare("float") == 0) {
+        std::vector<double> A_abs(A_data, A_data + N * N);
+        std::vector<double> B_abs(B_data, B_data + N * N);
+        std::transform(A_abs.begin(), A_abs.end(), A_abs.begin(),
+                       [](double a) { return std::abs(a); });
+        std::transform(B_abs.begin(), B_abs.end(), B_abs.begin(),
+                       [](double b) { return std::abs(b); });
+        matmul::gemm(matmul::engine::naive, {N, N, N},
+                     {A_abs.data(), B_abs.data(), error_bound.data()},
+                     {N, N, N}, reference_options);
+        double scale =
+            static_cast<double>(N) * std::numeric_limits<float>::epsilon();
+        std::transform(error_bound.begin(), error_bound.end(),
+                       error_bound.begin(),
+                       [scale](double bound) { return scale * bound; });
+      }
+      bool ok = true;
+      for (size_t k = 0; k < N * N; k++) {
+        ok = ok && std::abs(C_data[k] - Cref[k]) <= error_bound[k];
+      }
+      verification = ok ? "passed" : "failed";
       if (ok) {
         std::cout << "check passed" << std::endl;
       } else {
@@ -420,12 +889,39 @@ int main(int argc, char *argv[]) {
       if (verbose >= 2) {
         std::vector<double> diff_matrix(N * N);
         for (size_t k = 0; k < N * N; k++) {
-          diff_matrix.at(k) = fabs(Cref.at(k) - C.at(k));
+          diff_matrix.at(k) = fabs(Cref.at(k) - C_data[k]);
         }
         std::cout << "diff_matrix:" << std::endl;
         print_matrix_host(N, diff_matrix);
       }
     }
+
+    util::run_record record;
+    record.algorithm = algorithm;
+    record.precision = precision;
+    record.M = N;
+    record.N = N;
+    record.K = N;
+    record.transposed = transposed;
+    if (algorithm.compare("combined") == 0 ||
+        algorithm.compare("kernel_tiled") == 0 ||
+        algorithm.compare("strassen") == 0 ||
+        algorithm.compare("out_of_core") == 0) {
+      std::stringstream blocking_string;
+      blocking_string << blocking;
+      record.blocking = blocking_string.str();
+    }
+    record.block_result = block_result;
+    record.block_input = block_input;
+    record.omp_threads = omp_get_max_threads();
+    record.hpx_threads = hpx_threads;
+    record.repetitions = repetitions;
+    record.inner_durations = inner_durations;
+    record.total_duration = duration;
+    record.flops = flops;
+    record.padded_flops = padded_flops > 0.0 ? padded_flops : flops;
+    record.verification = verification;
+    util::append_record(record, output_format, output_file);
   }
   return return_value;
 }
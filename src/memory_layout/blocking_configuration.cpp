@@ -0,0 +1,83 @@
+#include "blocking_configuration.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "memory_layout_exception.hpp"
+
+namespace memory_layout {
+
+void blocking_configuration::verify() const {
+  if (X_REG == 0 || Y_REG == 0 || L1_X == 0 || L1_Y == 0 || L1_K_STEP == 0 ||
+      L2_X == 0 || L2_Y == 0 || L2_K_STEP == 0 || L3_X == 0 || L3_Y == 0 ||
+      L3_K_STEP == 0) {
+    throw memory_layout_exception("blocking sizes have to be larger than 0");
+  }
+  if (!((L2_X % L1_X == 0) && (L3_X % L2_X == 0))) {
+    throw memory_layout_exception(
+        "x direction blocking not set up correctly (L2_X = " +
+        std::to_string(L2_X) + " has to be a multiple of L1_X = " +
+        std::to_string(L1_X) + ", L3_X = " + std::to_string(L3_X) +
+        " a multiple of L2_X)");
+  }
+  if (!((L2_Y % L1_Y == 0) && (L3_Y % L2_Y == 0))) {
+    throw memory_layout_exception(
+        "y direction blocking not set up correctly (L2_Y = " +
+        std::to_string(L2_Y) + " has to be a multiple of L1_Y = " +
+        std::to_string(L1_Y) + ", L3_Y = " + std::to_string(L3_Y) +
+        " a multiple of L2_Y)");
+  }
+  if (!((L2_K_STEP % L1_K_STEP == 0) && (L3_K_STEP % L2_K_STEP == 0))) {
+    throw memory_layout_exception(
+        "k direction blocking not set up correctly (L2_K_STEP = " +
+        std::to_string(L2_K_STEP) + " has to be a multiple of L1_K_STEP = " +
+        std::to_string(L1_K_STEP) + ", L3_K_STEP = " +
+        std::to_string(L3_K_STEP) + " a multiple of L2_K_STEP)");
+  }
+  if (L1_X % X_REG != 0) {
+    throw memory_layout_exception(
+        "L1_X = " + std::to_string(L1_X) +
+        " has to be a multiple of the register blocking X_REG = " +
+        std::to_string(X_REG));
+  }
+  if (L1_Y % Y_REG != 0) {
+    throw memory_layout_exception(
+        "L1_Y = " + std::to_string(L1_Y) +
+        " has to be a multiple of the register blocking Y_REG = " +
+        std::to_string(Y_REG));
+  }
+}
+
+void blocking_configuration::set_register_blocking(const std::string &shape) {
+  size_t separator = shape.find('x');
+  try {
+    size_t x_length;
+    size_t y_length;
+    X_REG = std::stoul(shape.substr(0, separator), &x_length);
+    Y_REG = std::stoul(shape.substr(separator + 1), &y_length);
+    if (separator == std::string::npos || x_length != separator ||
+        separator + 1 + y_length != shape.size()) {
+      throw std::invalid_argument(shape);
+    }
+  } catch (const std::logic_error &) {
+    throw memory_layout_exception("invalid register blocking \"" + shape +
+                                  "\", expected e.g. \"5x8\"");
+  }
+}
+
+bool operator==(const blocking_configuration &a,
+                const blocking_configuration &b) {
+  return a.L3_X == b.L3_X && a.L3_Y == b.L3_Y && a.L3_K_STEP == b.L3_K_STEP &&
+         a.L2_X == b.L2_X && a.L2_Y == b.L2_Y && a.L2_K_STEP == b.L2_K_STEP &&
+         a.L1_X == b.L1_X && a.L1_Y == b.L1_Y && a.L1_K_STEP == b.L1_K_STEP &&
+         a.X_REG == b.X_REG && a.Y_REG == b.Y_REG;
+}
+
+std::ostream &operator<<(std::ostream &os, const blocking_configuration &b) {
+  os << "L3: " << b.L3_X << "x" << b.L3_Y << "x" << b.L3_K_STEP
+     << ", L2: " << b.L2_X << "x" << b.L2_Y << "x" << b.L2_K_STEP
+     << ", L1: " << b.L1_X << "x" << b.L1_Y << "x" << b.L1_K_STEP
+     << ", register: " << b.X_REG << "x" << b.Y_REG;
+  return os;
+}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace memory_layout {
+
+// cache blocking of the tiled engines (kernel_tiled, combined), all sizes in
+// elements, defaults are the best parameters found on an i7 6700k
+struct blocking_configuration {
+  size_t L3_X = 420; // max 2 L3 par set to 1024 (rest 512)
+  size_t L3_Y = 256;
+  size_t L3_K_STEP = 256;
+  size_t L2_X = 70; // max 2 L2 par set to 128 (rest 64)
+  size_t L2_Y = 64;
+  size_t L2_K_STEP = 128;
+  size_t L1_X = 35; // max all L1 par set to 32
+  size_t L1_Y = 16;
+  size_t L1_K_STEP = 64;
+  // register blocking, selects the micro kernel
+  size_t X_REG = 5;
+  size_t Y_REG = 8;
+
+  // checks that every cache level is a multiple of the next lower one and that
+  // the L1 tiles can be covered by the register blocking, throws
+  // memory_layout_exception otherwise
+  void verify() const;
+
+  // parses a register blocking of the form "5x8"
+  void set_register_blocking(const std::string &shape);
+};
+
+bool operator==(const blocking_configuration &a,
+                const blocking_configuration &b);
+
+std::ostream &operator<<(std::ostream &os, const blocking_configuration &b);
+}
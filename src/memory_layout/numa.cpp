@@ -0,0 +1,215 @@
+#include "numa.hpp"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <omp.h>
+
+#include "memory_layout_exception.hpp"
+
+namespace memory_layout {
+namespace numa {
+
+namespace {
+
+// keeps the reads of print_node_bandwidth from being optimized away
+volatile uint64_t read_sink;
+
+// cpus the process was allowed to run on at startup, binding a thread later
+// doesn't shrink this set
+const cpu_set_t &initial_affinity() {
+  static cpu_set_t mask = []() {
+    cpu_set_t m;
+    CPU_ZERO(&m);
+    if (sched_getaffinity(0, sizeof(m), &m) != 0) {
+      for (size_t cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+        CPU_SET(cpu, &m);
+      }
+    }
+    return m;
+  }();
+  return mask;
+}
+
+// parses a cpu list like "0-7,16-23"
+std::vector<size_t> parse_cpu_list(const std::string &list) {
+  std::vector<size_t> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    size_t dash = range.find('-');
+    size_t first = std::stoul(range.substr(0, dash));
+    size_t last =
+        dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+    for (size_t cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// cpus of every node, without the cpus the process isn't allowed to use
+const std::vector<std::vector<size_t>> &topology() {
+  static std::vector<std::vector<size_t>> nodes = []() {
+    std::vector<std::vector<size_t>> t;
+    for (size_t node = 0;; node++) {
+      std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) +
+                      "/cpulist");
+      std::string list;
+      if (!f || !std::getline(f, list)) {
+        break;
+      }
+      std::vector<size_t> cpus;
+      for (size_t cpu : parse_cpu_list(list)) {
+        if (CPU_ISSET(cpu, &initial_affinity())) {
+          cpus.push_back(cpu);
+        }
+      }
+      t.push_back(cpus);
+    }
+    if (t.empty()) {
+      std::vector<size_t> cpus;
+      for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &initial_affinity())) {
+          cpus.push_back(cpu);
+        }
+      }
+      t.push_back(cpus);
+    }
+    return t;
+  }();
+  return nodes;
+}
+}
+
+size_t node_count() { return topology().size(); }
+
+std::vector<size_t> node_cpus(size_t node) {
+  if (node >= node_count()) {
+    throw memory_layout_exception("NUMA node " + std::to_string(node) +
+                                  " doesn't exist");
+  }
+  return topology()[node];
+}
+
+size_t current_node() {
+  int cpu = sched_getcpu();
+  if (cpu < 0) {
+    return 0;
+  }
+  for (size_t node = 0; node < node_count(); node++) {
+    const std::vector<size_t> &cpus = topology()[node];
+    if (std::find(cpus.begin(), cpus.end(), static_cast<size_t>(cpu)) !=
+        cpus.end()) {
+      return node;
+    }
+  }
+  return 0;
+}
+
+void bind_to_node(size_t node) {
+  std::vector<size_t> cpus = node_cpus(node);
+  if (cpus.empty()) {
+    throw memory_layout_exception("no usable cpus on NUMA node " +
+                                  std::to_string(node));
+  }
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (size_t cpu : cpus) {
+    CPU_SET(cpu, &mask);
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    throw memory_layout_exception("could not bind thread to NUMA node " +
+                                  std::to_string(node));
+  }
+}
+
+void bind_openmp_threads() {
+  // nodes that the process may use, e.g. in a cpuset only some of them
+  std::vector<size_t> usable;
+  for (size_t node = 0; node < node_count(); node++) {
+    if (!topology()[node].empty()) {
+      usable.push_back(node);
+    }
+  }
+  bool failed = false;
+#pragma omp parallel
+  {
+    size_t t = omp_get_thread_num();
+    size_t threads = omp_get_num_threads();
+    try {
+      bind_to_node(usable[t * usable.size() / threads]);
+    } catch (memory_layout_exception &) {
+#pragma omp atomic write
+      failed = true;
+    }
+  }
+  if (failed) {
+    throw memory_layout_exception("could not bind the OpenMP threads to the "
+                                  "NUMA nodes");
+  }
+}
+
+void print_node_bandwidth(const std::string &name, const void *data,
+                          size_t bytes, std::ostream &out) {
+  const size_t nodes = node_count();
+  const size_t words = bytes / sizeof(uint64_t);
+  const uint64_t *p = static_cast<const uint64_t *>(data);
+  std::vector<size_t> node_threads(nodes, 0);
+  std::vector<double> node_seconds(nodes, 0.0);
+
+#pragma omp parallel
+  {
+    size_t node = current_node();
+    size_t rank;
+#pragma omp critical
+    rank = node_threads[node]++;
+#pragma omp barrier
+    // the threads of a node split the slice of the node
+    size_t slice_begin = node * words / nodes;
+    size_t slice_end = (node + 1) * words / nodes;
+    size_t slice = slice_end - slice_begin;
+    size_t begin = slice_begin + rank * slice / node_threads[node];
+    size_t end = slice_begin + (rank + 1) * slice / node_threads[node];
+
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    uint64_t x = 0;
+    for (size_t i = begin; i < end; i++) {
+      x ^= p[i];
+    }
+    std::chrono::high_resolution_clock::time_point stop =
+        std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+#pragma omp critical
+    {
+      node_seconds[node] = std::max(node_seconds[node], seconds);
+      read_sink = read_sink ^ x;
+    }
+  }
+
+  for (size_t node = 0; node < nodes; node++) {
+    double slice_bytes = static_cast<double>(
+        ((node + 1) * words / nodes - node * words / nodes) * sizeof(uint64_t));
+    out << name << " on node " << node << ": " << (slice_bytes / 1E6)
+        << " MB, ";
+    if (node_threads[node] == 0) {
+      out << "no threads on this node (threads not bound?)";
+    } else {
+      out << (slice_bytes / 1E9 / node_seconds[node]) << " GB/s read by "
+          << node_threads[node] << " threads";
+    }
+    out << std::endl;
+  }
+}
+}
+}
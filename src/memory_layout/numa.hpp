@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace memory_layout {
+namespace numa {
+
+// NUMA topology as reported by /sys/devices/system/node, a machine without
+// that information is treated as a single node with all cpus
+
+size_t node_count();
+
+// cpus of the node that the calling process may run on
+std::vector<size_t> node_cpus(size_t node);
+
+// node of the cpu the calling thread currently runs on
+size_t current_node();
+
+// restricts the calling thread to the cpus of node, throws
+// memory_layout_exception if that isn't possible
+void bind_to_node(size_t node);
+
+// binds the threads of the OpenMP team to the nodes in order, thread t runs on
+// node t * nodes / threads, so that the contiguous chunks of the static
+// schedules (packing, first touch) are placed socket by socket
+void bind_openmp_threads();
+
+// Measures the read bandwidth of every node on its part of a buffer that was
+// first-touched by the bound OpenMP threads (node n owns the n-th of
+// node_count() contiguous slices). All nodes read at the same time, as during
+// a multiply.
+void print_node_bandwidth(const std::string &name, const void *data,
+                          size_t bytes, std::ostream &out = std::cout);
+}
+}
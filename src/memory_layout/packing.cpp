@@ -0,0 +1,212 @@
+#include "packing.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <emmintrin.h>
+
+#include <Vc/Vc>
+#include <boost/align/aligned_allocator.hpp>
+
+namespace memory_layout {
+namespace packing {
+
+namespace {
+
+// tiles are assembled in this cache-resident buffer and then streamed to their
+// destination, there is one buffer per worker thread and element type
+template <typename T> T *get_tile_buffer(size_t size) {
+  static thread_local std::vector<T, boost::alignment::aligned_allocator<T, 64>>
+      buffer;
+  if (buffer.size() < size) {
+    buffer.resize(size);
+  }
+  return buffer.data();
+}
+
+// non-temporal stores of 16 bytes, the destination has to be 16-byte aligned
+inline void stream_store(double *dst, const double *src) {
+  _mm_stream_pd(dst, _mm_loadu_pd(src));
+}
+
+inline void stream_store(float *dst, const float *src) {
+  _mm_stream_ps(dst, _mm_loadu_ps(src));
+}
+
+// copies with non-temporal stores, so that the destination doesn't evict the
+// source from the caches and isn't read before being written
+template <typename T> void stream_copy(const T *src, T *dst, size_t count) {
+  constexpr size_t width = 16 / sizeof(T);
+  size_t i = 0;
+  for (; i < count && reinterpret_cast<uintptr_t>(dst + i) % 16 != 0; i++) {
+    dst[i] = src[i];
+  }
+  for (; i + width <= count; i += width) {
+    stream_store(dst + i, src + i);
+  }
+  for (; i < count; i++) {
+    dst[i] = src[i];
+  }
+}
+
+template <typename T> void stream_zero(T *dst, size_t count) {
+  constexpr size_t width = 16 / sizeof(T);
+  const T zeros[width] = {};
+  size_t i = 0;
+  for (; i < count && reinterpret_cast<uintptr_t>(dst + i) % 16 != 0; i++) {
+    dst[i] = T(0);
+  }
+  for (; i + width <= count; i += width) {
+    stream_store(dst + i, zeros);
+  }
+  for (; i < count; i++) {
+    dst[i] = T(0);
+  }
+}
+
+// row[i] = M[i * stride] for i < count, zero for count <= i < count_padded
+template <typename T>
+void gather_strided(const T *M, size_t stride, size_t count,
+                    size_t count_padded, T *row) {
+  using vector_t = Vc::Vector<T>;
+  typename vector_t::IndexType indices;
+  for (size_t i = 0; i < vector_t::Size; i++) {
+    indices[i] = static_cast<int>(i * stride);
+  }
+  size_t i = 0;
+  for (; i + vector_t::Size <= count; i += vector_t::Size) {
+    vector_t v(M + i * stride, indices);
+    v.store(row + i, Vc::flags::element_aligned);
+  }
+  for (; i < count; i++) {
+    row[i] = M[i * stride];
+  }
+  for (; i < count_padded; i++) {
+    row[i] = T(0);
+  }
+}
+}
+
+template <typename T>
+void pack_A_tile(const T *A, size_t X_org, size_t K_org, size_t lda,
+                 bool transposed, size_t x_begin, size_t k_begin, size_t L1_X,
+                 size_t L1_K_STEP, T *tile) {
+  T *buffer = get_tile_buffer<T>(L1_X * L1_K_STEP);
+  // rows and columns of the tile that are not padding
+  size_t x_count = x_begin < X_org ? std::min(L1_X, X_org - x_begin) : 0;
+  size_t k_count = k_begin < K_org ? std::min(L1_K_STEP, K_org - k_begin) : 0;
+  for (size_t k = 0; k < L1_K_STEP; k++) {
+    T *buffer_row = buffer + k * L1_X;
+    if (k >= k_count) {
+      std::fill(buffer_row, buffer_row + L1_X, T(0));
+    } else if (!transposed) {
+      gather_strided(A + x_begin * lda + (k_begin + k), lda, x_count, L1_X,
+                     buffer_row);
+    } else {
+      // a row of the tile is contiguous in the transposed storage
+      const T *A_row = A + (k_begin + k) * lda + x_begin;
+      std::copy(A_row, A_row + x_count, buffer_row);
+      std::fill(buffer_row + x_count, buffer_row + L1_X, T(0));
+    }
+  }
+  stream_copy(buffer, tile, L1_X * L1_K_STEP);
+  _mm_sfence();
+}
+
+template <typename T>
+void pack_B_tile(const T *B, size_t K_org, size_t Y_org, size_t ldb,
+                 bool transposed, size_t k_begin, size_t y_begin, size_t L1_Y,
+                 size_t L1_K_STEP, T *tile) {
+  size_t y_count = y_begin < Y_org ? std::min(L1_Y, Y_org - y_begin) : 0;
+  size_t k_count = k_begin < K_org ? std::min(L1_K_STEP, K_org - k_begin) : 0;
+  if (transposed) {
+    // the columns of op(B) are strided, assemble the tile in the buffer
+    T *buffer = get_tile_buffer<T>(L1_Y * L1_K_STEP);
+    for (size_t k = 0; k < L1_K_STEP; k++) {
+      T *buffer_row = buffer + k * L1_Y;
+      if (k < k_count) {
+        gather_strided(B + y_begin * ldb + (k_begin + k), ldb, y_count, L1_Y,
+                       buffer_row);
+      } else {
+        std::fill(buffer_row, buffer_row + L1_Y, T(0));
+      }
+    }
+    stream_copy(buffer, tile, L1_Y * L1_K_STEP);
+    _mm_sfence();
+    return;
+  }
+  // rows of B are contiguous, no need for the buffer
+  for (size_t k = 0; k < L1_K_STEP; k++) {
+    T *tile_row = tile + k * L1_Y;
+    if (k < k_count) {
+      stream_copy(B + (k_begin + k) * ldb + y_begin, tile_row, y_count);
+      stream_zero(tile_row + y_count, L1_Y - y_count);
+    } else {
+      stream_zero(tile_row, L1_Y);
+    }
+  }
+  _mm_sfence();
+}
+
+template <typename T>
+void unpack_C_tile(const T *tile, size_t L1_X, size_t L1_Y, T *C, size_t X_org,
+                   size_t Y_org, size_t ldc, size_t x_begin, size_t y_begin) {
+  if (x_begin >= X_org || y_begin >= Y_org) {
+    return; // padding only
+  }
+  size_t x_count = std::min(L1_X, X_org - x_begin);
+  size_t y_count = std::min(L1_Y, Y_org - y_begin);
+  for (size_t x = 0; x < x_count; x++) {
+    stream_copy(tile + x * L1_Y, C + (x_begin + x) * ldc + y_begin, y_count);
+  }
+  _mm_sfence();
+}
+
+template <typename T>
+void pad_row(const T *M, size_t rows, size_t cols, size_t ld, bool transposed,
+             size_t r, T *row, size_t cols_padded) {
+  if (!transposed) {
+    if (r < rows) {
+      stream_copy(M + r * ld, row, cols);
+      stream_zero(row + cols, cols_padded - cols);
+    } else {
+      stream_zero(row, cols_padded);
+    }
+  } else {
+    // row r of the transposed matrix is column r of M
+    if (r < cols) {
+      T *buffer = get_tile_buffer<T>(cols_padded);
+      gather_strided(M + r, ld, rows, cols_padded, buffer);
+      stream_copy(buffer, row, cols_padded);
+    } else {
+      stream_zero(row, cols_padded);
+    }
+  }
+  _mm_sfence();
+}
+
+template <typename T>
+void unpad_row(const T *M_padded, size_t cols_padded, size_t r, T *row,
+               size_t cols) {
+  stream_copy(M_padded + r * cols_padded, row, cols);
+  _mm_sfence();
+}
+
+#define INSTANTIATE_PACKING(T)                                                 \
+  template void pack_A_tile<T>(const T *, size_t, size_t, size_t, bool,        \
+                               size_t, size_t, size_t, size_t, T *);           \
+  template void pack_B_tile<T>(const T *, size_t, size_t, size_t, bool,        \
+                               size_t, size_t, size_t, size_t, T *);           \
+  template void unpack_C_tile<T>(const T *, size_t, size_t, T *, size_t,       \
+                                 size_t, size_t, size_t, size_t);              \
+  template void pad_row<T>(const T *, size_t, size_t, size_t, bool, size_t,    \
+                           T *, size_t);                                       \
+  template void unpad_row<T>(const T *, size_t, size_t, T *, size_t);
+
+INSTANTIATE_PACKING(double)
+INSTANTIATE_PACKING(float)
+
+#undef INSTANTIATE_PACKING
+}
+}
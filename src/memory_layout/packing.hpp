@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace memory_layout {
+namespace packing {
+
+// Packing and unpacking of the operands of the tiled engines (kernel_tiled,
+// combined, proposal) for double and float elements. The source matrices are
+// row-major with a leading dimension, the packed matrices are padded to the
+// given sizes and the padding is filled with zeros. The tile functions use
+// SIMD gathers for the strided accesses and write their destination with
+// streaming stores, the drivers below distribute the tiles with the given
+// parallel policy (openmp_policy here, hpx_policy in packing_hpx.hpp).
+
+// The padded sizes only have to be multiples of the register blocking, the L1
+// tiles at the upper edges are as large as the remaining part of the matrix.
+// Inside of a tile the layout is the same as for full tiles. A_trans and
+// B_tiled are stored as panels: all tiles of an L1_X (L1_Y) wide strip follow
+// each other in k direction, so that a micro kernel can run over any k range
+// of a strip with contiguous accesses. C_tiled is ordered x-block-major.
+
+// extent of the tile starting at begin
+inline size_t tile_extent(size_t begin, size_t size, size_t L1) {
+  return std::min(L1, size - begin);
+}
+
+// base index of the tile starting at (outer_begin, k_begin) of a packed
+// operand, outer is x for A_trans and y for B_tiled, L1_outer is L1_X or L1_Y,
+// row k of a strip starts at operand_tile_base(outer_begin, 0, ...) + k * width
+inline size_t operand_tile_base(size_t outer_begin, size_t k_begin,
+                                size_t outer_size, size_t K_size,
+                                size_t L1_outer) {
+  return outer_begin * K_size +
+         k_begin * tile_extent(outer_begin, outer_size, L1_outer);
+}
+
+// base index of the tile starting at (x_begin, y_begin) of C_tiled
+inline size_t result_tile_base(size_t x_begin, size_t y_begin, size_t X_size,
+                               size_t Y_size, size_t L1_X) {
+  return x_begin * Y_size + y_begin * tile_extent(x_begin, X_size, L1_X);
+}
+
+// packs the L1_X x L1_K_STEP tile of op(A) starting at (x_begin, k_begin)
+// transposed into tile, tile[k * L1_X + x] = op(A)[x_begin + x][k_begin + k],
+// op(A) is X_org x K_org, A is stored K_org x X_org if transposed
+template <typename T>
+void pack_A_tile(const T *A, size_t X_org, size_t K_org, size_t lda,
+                 bool transposed, size_t x_begin, size_t k_begin, size_t L1_X,
+                 size_t L1_K_STEP, T *tile);
+
+// packs the L1_K_STEP x L1_Y tile of op(B) starting at (k_begin, y_begin)
+// into tile, tile[k * L1_Y + y] = op(B)[k_begin + k][y_begin + y], op(B) is
+// K_org x Y_org, B is stored Y_org x K_org if transposed
+template <typename T>
+void pack_B_tile(const T *B, size_t K_org, size_t Y_org, size_t ldb,
+                 bool transposed, size_t k_begin, size_t y_begin, size_t L1_Y,
+                 size_t L1_K_STEP, T *tile);
+
+// writes the L1_X x L1_Y tile of C starting at (x_begin, y_begin) back, the
+// part in the padding is skipped
+template <typename T>
+void unpack_C_tile(const T *tile, size_t L1_X, size_t L1_Y, T *C,
+                   size_t X_org, size_t Y_org, size_t ldc, size_t x_begin,
+                   size_t y_begin);
+
+// writes row r of the (transposed if requested) padded matrix
+template <typename T>
+void pad_row(const T *M, size_t rows, size_t cols, size_t ld, bool transposed,
+             size_t r, T *row, size_t cols_padded);
+
+// copies a row-major matrix without the padding
+template <typename T>
+void unpad_row(const T *M_padded, size_t cols_padded, size_t r, T *row,
+               size_t cols);
+
+struct openmp_policy {
+  template <typename F> static void parallel_for(size_t count, F f) {
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < count; i++) {
+      f(i);
+    }
+  }
+};
+
+// A_trans has to hold X_size * K_size elements
+template <typename policy, typename T>
+void pack_A(const T *A, size_t X_org, size_t K_org, size_t lda,
+            bool transposed, T *A_trans, size_t X_size, size_t K_size,
+            size_t L1_X, size_t L1_K_STEP) {
+  const size_t blocks_x = (X_size + L1_X - 1) / L1_X;
+  const size_t blocks_k = (K_size + L1_K_STEP - 1) / L1_K_STEP;
+  // consecutive tiles are adjacent in memory, so that the static schedules
+  // first-touch contiguous ranges
+  policy::parallel_for(blocks_x * blocks_k, [=](size_t i) {
+    size_t x_begin = (i / blocks_k) * L1_X;
+    size_t k_begin = (i % blocks_k) * L1_K_STEP;
+    pack_A_tile(
+        A, X_org, K_org, lda, transposed, x_begin, k_begin,
+        tile_extent(x_begin, X_size, L1_X),
+        tile_extent(k_begin, K_size, L1_K_STEP),
+        A_trans + operand_tile_base(x_begin, k_begin, X_size, K_size, L1_X));
+  });
+}
+
+template <typename policy, typename T>
+void pack_B(const T *B, size_t K_org, size_t Y_org, size_t ldb,
+            bool transposed, T *B_tiled, size_t Y_size, size_t K_size,
+            size_t L1_Y, size_t L1_K_STEP) {
+  const size_t blocks_y = (Y_size + L1_Y - 1) / L1_Y;
+  const size_t blocks_k = (K_size + L1_K_STEP - 1) / L1_K_STEP;
+  policy::parallel_for(blocks_y * blocks_k, [=](size_t i) {
+    size_t y_begin = (i / blocks_k) * L1_Y;
+    size_t k_begin = (i % blocks_k) * L1_K_STEP;
+    pack_B_tile(
+        B, K_org, Y_org, ldb, transposed, k_begin, y_begin,
+        tile_extent(y_begin, Y_size, L1_Y),
+        tile_extent(k_begin, K_size, L1_K_STEP),
+        B_tiled + operand_tile_base(y_begin, k_begin, Y_size, K_size, L1_Y));
+  });
+}
+
+template <typename policy, typename T>
+void unpack_C(const T *C_tiled, size_t X_size, size_t Y_size, size_t L1_X,
+              size_t L1_Y, T *C, size_t X_org, size_t Y_org, size_t ldc) {
+  const size_t blocks_x = (X_size + L1_X - 1) / L1_X;
+  const size_t blocks_y = (Y_size + L1_Y - 1) / L1_Y;
+  policy::parallel_for(blocks_x * blocks_y, [=](size_t i) {
+    size_t x_begin = (i / blocks_y) * L1_X;
+    size_t y_begin = (i % blocks_y) * L1_Y;
+    unpack_C_tile(
+        C_tiled + result_tile_base(x_begin, y_begin, X_size, Y_size, L1_X),
+        tile_extent(x_begin, X_size, L1_X), tile_extent(y_begin, Y_size, L1_Y),
+        C, X_org, Y_org, ldc, x_begin, y_begin);
+  });
+}
+
+// untiled, padded (and optionally transposed) copy of a matrix, M_padded has
+// rows_padded x cols_padded elements (of the transposed matrix if transposed)
+template <typename policy, typename T>
+void pad(const T *M, size_t rows, size_t cols, size_t ld, bool transposed,
+         T *M_padded, size_t rows_padded, size_t cols_padded) {
+  policy::parallel_for(rows_padded, [=](size_t r) {
+    pad_row(M, rows, cols, ld, transposed, r, M_padded + r * cols_padded,
+            cols_padded);
+  });
+}
+
+template <typename policy, typename T>
+void unpad(const T *M_padded, size_t cols_padded, T *M, size_t rows,
+           size_t cols) {
+  policy::parallel_for(rows, [=](size_t r) {
+    unpad_row(M_padded, cols_padded, r, M + r * cols, cols);
+  });
+}
+}
+}
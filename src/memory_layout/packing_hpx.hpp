@@ -0,0 +1,21 @@
+#pragma once
+
+#include "packing.hpp"
+
+#include <hpx/parallel/algorithms/for_each.hpp>
+
+#include <boost/iterator/counting_iterator.hpp>
+
+namespace memory_layout {
+namespace packing {
+
+// distributes the tiles as HPX tasks, for the engines that run inside of
+// hpx_main
+struct hpx_policy {
+  template <typename F> static void parallel_for(size_t count, F f) {
+    hpx::parallel::for_each_n(hpx::parallel::par,
+                              boost::counting_iterator<size_t>(0), count, f);
+  }
+};
+}
+}
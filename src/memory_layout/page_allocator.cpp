@@ -0,0 +1,147 @@
+#include "page_allocator.hpp"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include "memory_layout_exception.hpp"
+
+namespace memory_layout {
+
+namespace {
+
+const size_t huge_page_size = 2 * 1024 * 1024;
+
+std::atomic<bool> huge_pages_enabled(false);
+
+struct mapping {
+  void *begin;
+  size_t bytes;
+  page_backing backing;
+};
+
+// live allocations, the mapped size can differ from the requested size
+std::mutex &mappings_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+std::map<const void *, mapping> &mappings() {
+  static std::map<const void *, mapping> m;
+  return m;
+}
+
+size_t round_up(size_t bytes, size_t multiple) {
+  return ((bytes + multiple - 1) / multiple) * multiple;
+}
+
+void *map_anonymous(size_t bytes, int extra_flags) {
+  void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+mapping map_pages(size_t bytes) {
+  if (huge_pages_enabled) {
+    const size_t huge_bytes = round_up(bytes, huge_page_size);
+#ifdef MAP_HUGETLB
+    // only succeeds if huge pages were reserved (vm.nr_hugepages)
+    if (void *p = map_anonymous(huge_bytes, MAP_HUGETLB)) {
+      return {p, huge_bytes, page_backing::huge_pages};
+    }
+#endif
+    // over-allocate to cut out a range aligned to the huge page size, so that
+    // the kernel can back all of it with transparent huge pages
+    if (char *p = static_cast<char *>(
+            map_anonymous(huge_bytes + huge_page_size, 0))) {
+      char *aligned = reinterpret_cast<char *>(
+          round_up(reinterpret_cast<uintptr_t>(p), huge_page_size));
+      if (aligned != p) {
+        munmap(p, aligned - p);
+      }
+      size_t tail = (p + huge_bytes + huge_page_size) - (aligned + huge_bytes);
+      if (tail > 0) {
+        munmap(aligned + huge_bytes, tail);
+      }
+#ifdef MADV_HUGEPAGE
+      if (madvise(aligned, huge_bytes, MADV_HUGEPAGE) == 0) {
+        return {aligned, huge_bytes, page_backing::transparent_huge_pages};
+      }
+#endif
+      return {aligned, huge_bytes, page_backing::small_pages};
+    }
+  }
+  void *p = map_anonymous(bytes, 0);
+  if (p == nullptr) {
+    // out of memory like any other allocator, so that callers handle it
+    // uniformly
+    throw std::bad_alloc();
+  }
+  return {p, bytes, page_backing::small_pages};
+}
+}
+
+std::string to_string(page_backing backing) {
+  switch (backing) {
+  case page_backing::huge_pages:
+    return "huge pages (MAP_HUGETLB)";
+  case page_backing::transparent_huge_pages:
+    return "transparent huge pages (madvise)";
+  default:
+    return "small pages";
+  }
+}
+
+void set_huge_pages(bool enabled) { huge_pages_enabled = enabled; }
+
+bool get_huge_pages() { return huge_pages_enabled; }
+
+page_backing get_page_backing(const void *p) {
+  std::lock_guard<std::mutex> lock(mappings_mutex());
+  auto it = mappings().find(p);
+  if (it == mappings().end()) {
+    throw memory_layout_exception(
+        "pointer wasn't allocated by page_allocator");
+  }
+  return it->second.backing;
+}
+
+namespace detail {
+
+void *allocate_pages(size_t bytes) {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  mapping m = map_pages(bytes);
+  std::lock_guard<std::mutex> lock(mappings_mutex());
+  mappings()[m.begin] = m;
+  return m.begin;
+}
+
+void free_pages(void *p, size_t) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  mapping m;
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex());
+    auto it = mappings().find(p);
+    if (it == mappings().end()) {
+      // called from destructors, reported instead of thrown
+      std::cerr << "warning: page_allocator can't free " << p
+                << ", it wasn't allocated by page_allocator" << std::endl;
+      return;
+    }
+    m = it->second;
+    mappings().erase(it);
+  }
+  munmap(m.begin, m.bytes);
+}
+}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace memory_layout {
+
+// pages that were obtained for an allocation
+enum class page_backing {
+  small_pages,            // 4 KB pages
+  transparent_huge_pages, // 2 MB aligned and marked with MADV_HUGEPAGE
+  huge_pages              // MAP_HUGETLB, reserved huge pages
+};
+
+std::string to_string(page_backing backing);
+
+// whether the following allocations try huge pages, first MAP_HUGETLB, then
+// transparent huge pages and finally small pages, off by default
+void set_huge_pages(bool enabled);
+
+bool get_huge_pages();
+
+// backing of the allocation starting at p (a pointer returned by
+// page_allocator), throws memory_layout_exception for other pointers
+page_backing get_page_backing(const void *p);
+
+namespace detail {
+
+// page-aligned memory straight from the operating system, the pages are only
+// mapped when they are first written (and are zero then), throws
+// std::bad_alloc if the mapping fails
+void *allocate_pages(size_t bytes);
+
+// never throws (deallocate mustn't), a pointer that wasn't returned by
+// allocate_pages is reported on stderr and ignored
+void free_pages(void *p, size_t bytes) noexcept;
+}
+
+// Allocator for the large packed buffers of the tiled engines. The memory is
+// page-aligned and the elements are not initialized when the vector is
+// resized, so that no page is touched before the parallel packing pass writes
+// it. On Linux a page is placed on the NUMA node of the thread that touches
+// it first, therefore the buffers end up distributed like the threads that
+// pack (or first-touch) them instead of all on the node of the main thread.
+// With set_huge_pages(true) the buffers are backed by huge pages if possible,
+// which saves most of the dTLB misses of the strided tile walks.
+template <typename T> class page_allocator {
+public:
+  using value_type = T;
+
+  page_allocator() = default;
+
+  template <typename U> page_allocator(const page_allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    if (n > static_cast<size_t>(-1) / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(detail::allocate_pages(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    detail::free_pages(p, n * sizeof(T));
+  }
+
+  // default-initialization, leaves the memory untouched for trivial types
+  template <typename U> void construct(U *p) {
+    ::new (static_cast<void *>(p)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&... args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const page_allocator<T> &, const page_allocator<U> &) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const page_allocator<T> &, const page_allocator<U> &) {
+  return false;
+}
+
+template <typename T> using page_vector = std::vector<T, page_allocator<T>>;
+}
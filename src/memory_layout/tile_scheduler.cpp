@@ -0,0 +1,103 @@
+#include "tile_scheduler.hpp"
+
+#include <limits>
+
+#include "memory_layout_exception.hpp"
+
+namespace memory_layout {
+
+namespace {
+
+std::atomic<tile_schedule> default_schedule(tile_schedule::static_schedule);
+
+uint64_t pack_bounds(uint64_t front, uint64_t back) {
+  return front | (back << 32);
+}
+
+uint64_t front_of(uint64_t bounds) { return bounds & 0xFFFFFFFF; }
+
+uint64_t back_of(uint64_t bounds) { return bounds >> 32; }
+}
+
+std::string to_string(tile_schedule schedule) {
+  switch (schedule) {
+  case tile_schedule::work_stealing:
+    return "stealing";
+  default:
+    return "static";
+  }
+}
+
+tile_schedule tile_schedule_from_string(const std::string &name) {
+  if (name.compare("static") == 0) {
+    return tile_schedule::static_schedule;
+  } else if (name.compare("stealing") == 0) {
+    return tile_schedule::work_stealing;
+  }
+  throw memory_layout_exception("unknown tile schedule \"" + name +
+                                "\", use static or stealing");
+}
+
+void set_tile_schedule(tile_schedule schedule) { default_schedule = schedule; }
+
+tile_schedule get_tile_schedule() { return default_schedule; }
+
+tile_scheduler::tile_scheduler(size_t tiles, size_t workers)
+    : workers(workers), ranges(new tile_range[workers]) {
+  if (workers == 0) {
+    throw memory_layout_exception("tile_scheduler needs at least one worker");
+  }
+  if (tiles > std::numeric_limits<uint32_t>::max()) {
+    throw memory_layout_exception("too many tiles for tile_scheduler");
+  }
+  for (size_t w = 0; w < workers; w++) {
+    ranges[w].bounds = pack_bounds(w * tiles / workers,
+                                   (w + 1) * tiles / workers);
+  }
+}
+
+bool tile_scheduler::take_front(size_t worker, size_t &tile) {
+  std::atomic<uint64_t> &bounds = ranges[worker].bounds;
+  uint64_t current = bounds.load();
+  while (front_of(current) < back_of(current)) {
+    if (bounds.compare_exchange_weak(
+            current, pack_bounds(front_of(current) + 1, back_of(current)))) {
+      tile = front_of(current);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool tile_scheduler::take_back(size_t victim, size_t &tile) {
+  std::atomic<uint64_t> &bounds = ranges[victim].bounds;
+  uint64_t current = bounds.load();
+  while (front_of(current) < back_of(current)) {
+    if (bounds.compare_exchange_weak(
+            current, pack_bounds(front_of(current), back_of(current) - 1))) {
+      tile = back_of(current) - 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool tile_scheduler::next(size_t worker, size_t &tile) {
+  if (take_front(worker, tile)) {
+    return true;
+  }
+  // ranges only shrink, so a victim that is empty once stays empty; the
+  // victims are visited by distance in the worker order, the lower one first,
+  // without wrapping around, so that the last worker of a socket doesn't
+  // start with the first worker of the next socket or worker 0
+  for (size_t distance = 1; distance < workers; distance++) {
+    if (worker >= distance && take_back(worker - distance, tile)) {
+      return true;
+    }
+    if (worker + distance < workers && take_back(worker + distance, tile)) {
+      return true;
+    }
+  }
+  return false;
+}
+}
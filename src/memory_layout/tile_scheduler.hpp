@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace memory_layout {
+
+// how the parallel loop over the L3 tiles of C hands out the tiles
+enum class tile_schedule {
+  static_schedule, // contiguous equal chunks, like omp for schedule(static)
+  work_stealing    // same initial chunks, idle workers steal from the others
+};
+
+std::string to_string(tile_schedule schedule);
+
+// throws memory_layout_exception for unknown names ("static", "stealing")
+tile_schedule tile_schedule_from_string(const std::string &name);
+
+// schedule used by kernel_tiled and combined, static by default
+void set_tile_schedule(tile_schedule schedule);
+
+tile_schedule get_tile_schedule();
+
+// Hands out the tiles 0, ..., tiles - 1 to a fixed number of workers. Worker
+// w starts with the contiguous range [w * tiles / workers, (w + 1) * tiles /
+// workers), the chunk it would get from a static schedule, so that it mostly
+// reads the packed strips it has first-touched. A worker takes its own tiles
+// from the front of its range and, once that is empty, steals single tiles
+// from the back of the ranges of the other workers, the closest ones in the
+// worker order first, alternating between lower and higher workers. With
+// threads bound in order, the workers it tries first are on its own socket,
+// unless it is at the edge of a socket, where the closest worker on the other
+// side of the edge comes as early as the second closest on its own socket.
+// A preempted thread therefore only delays the tile it is working on instead
+// of its whole chunk. Lock-free, usable from OpenMP threads and HPX tasks.
+class tile_scheduler {
+private:
+  // range of a worker, front in the low and back in the high 32 bits, padded
+  // so that no two ranges share a cache line
+  struct tile_range {
+    std::atomic<uint64_t> bounds;
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  size_t workers;
+  std::unique_ptr<tile_range[]> ranges;
+
+  bool take_front(size_t worker, size_t &tile);
+
+  bool take_back(size_t victim, size_t &tile);
+
+public:
+  // throws memory_layout_exception if workers is 0 or tiles doesn't fit into
+  // 32 bits
+  tile_scheduler(size_t tiles, size_t workers);
+
+  size_t get_workers() const { return workers; }
+
+  // next tile for worker, false if no tiles are left anywhere
+  bool next(size_t worker, size_t &tile);
+};
+}
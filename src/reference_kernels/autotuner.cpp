@@ -0,0 +1,257 @@
+#include "autotuner.hpp"
+
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "micro_kernel.hpp"
+
+namespace autotuner {
+
+std::string get_cpu_model() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      size_t colon = line.find(':');
+      if (colon != std::string::npos && colon + 2 <= line.size()) {
+        return line.substr(colon + 2);
+      }
+    }
+  }
+  return "unknown";
+}
+
+size_t get_size_class(size_t N) {
+  size_t size_class = 64;
+  while (size_class < N) {
+    size_class *= 2;
+  }
+  return size_class;
+}
+
+tuning_key make_tuning_key(const std::string &algorithm, size_t threads,
+                           size_t N) {
+  return tuning_key{get_cpu_model(),
+                    micro_kernel::to_string(micro_kernel::get_isa()),
+                    algorithm, threads, get_size_class(N)};
+}
+
+namespace detail {
+
+std::string key_prefix(const tuning_key &key) {
+  std::stringstream s;
+  s << key.cpu_model << "\t" << key.isa << "\t" << key.algorithm << "\t"
+    << key.threads << "\t" << key.size_class << "\t";
+  return s.str();
+}
+
+// internal representation of the search space, the first entry selects the
+// register shape, every cache level is stored as a multiple of the next lower
+// one, so that all points are valid blockings
+typedef std::array<size_t, 10> factors;
+
+factors to_factors(const memory_layout::blocking_configuration &b,
+                   size_t shape_index) {
+  return {{shape_index, b.L1_X / b.X_REG, b.L1_Y / b.Y_REG, b.L1_K_STEP,
+           b.L2_X / b.L1_X, b.L2_Y / b.L1_Y, b.L2_K_STEP / b.L1_K_STEP,
+           b.L3_X / b.L2_X, b.L3_Y / b.L2_Y, b.L3_K_STEP / b.L2_K_STEP}};
+}
+
+memory_layout::blocking_configuration
+to_blocking(const factors &f,
+            const std::vector<std::pair<size_t, size_t>> &register_shapes) {
+  memory_layout::blocking_configuration b;
+  b.X_REG = register_shapes[f[0]].first;
+  b.Y_REG = register_shapes[f[0]].second;
+  b.L1_X = f[1] * b.X_REG;
+  b.L1_Y = f[2] * b.Y_REG;
+  b.L1_K_STEP = f[3];
+  b.L2_X = b.L1_X * f[4];
+  b.L2_Y = b.L1_Y * f[5];
+  b.L2_K_STEP = b.L1_K_STEP * f[6];
+  b.L3_X = b.L2_X * f[7];
+  b.L3_Y = b.L2_Y * f[8];
+  b.L3_K_STEP = b.L2_K_STEP * f[9];
+  return b;
+}
+
+// rounds to the closest non-zero multiple
+size_t round_to_multiple(size_t value, size_t multiple) {
+  size_t rounded = ((value + multiple / 2) / multiple) * multiple;
+  return rounded == 0 ? multiple : rounded;
+}
+
+// changes the register shape and keeps the cache blocking as close as possible
+// to the previous one
+factors
+change_shape(const factors &f, size_t shape_index,
+             const std::vector<std::pair<size_t, size_t>> &register_shapes) {
+  memory_layout::blocking_configuration b = to_blocking(f, register_shapes);
+  b.X_REG = register_shapes[shape_index].first;
+  b.Y_REG = register_shapes[shape_index].second;
+  b.L1_X = round_to_multiple(b.L1_X, b.X_REG);
+  b.L1_Y = round_to_multiple(b.L1_Y, b.Y_REG);
+  b.L2_X = round_to_multiple(b.L2_X, b.L1_X);
+  b.L2_Y = round_to_multiple(b.L2_Y, b.L1_Y);
+  b.L3_X = round_to_multiple(b.L3_X, b.L2_X);
+  b.L3_Y = round_to_multiple(b.L3_Y, b.L2_Y);
+  return to_factors(b, shape_index);
+}
+
+// candidate values per search dimension, same order as factors, without the
+// register shapes
+const std::array<std::vector<size_t>, 9> candidates = {{
+    {1, 2, 3, 4, 5, 6, 7, 8}, // L1_X / X_REG
+    {1, 2, 3, 4},             // L1_Y / Y_REG
+    {16, 32, 64, 128, 256},   // L1_K_STEP
+    {1, 2, 3, 4},             // L2_X / L1_X
+    {1, 2, 3, 4},             // L2_Y / L1_Y
+    {1, 2, 4},                // L2_K_STEP / L1_K_STEP
+    {1, 2, 3, 4, 6, 8},       // L3_X / L2_X
+    {1, 2, 3, 4, 6, 8},       // L3_Y / L2_Y
+    {1, 2, 4}                 // L3_K_STEP / L2_K_STEP
+}};
+}
+
+tuning_cache::tuning_cache(const std::string &file_name)
+    : file_name(file_name) {}
+
+bool tuning_cache::lookup(
+    const tuning_key &key,
+    memory_layout::blocking_configuration &blocking) const {
+  std::ifstream f(file_name);
+  std::string prefix = detail::key_prefix(key);
+  std::string line;
+  while (std::getline(f, line)) {
+    if (line.compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    std::stringstream s(line.substr(prefix.size()));
+    memory_layout::blocking_configuration b;
+    s >> b.L3_X >> b.L3_Y >> b.L3_K_STEP >> b.L2_X >> b.L2_Y >> b.L2_K_STEP >>
+        b.L1_X >> b.L1_Y >> b.L1_K_STEP >> b.X_REG >> b.Y_REG;
+    if (!s) {
+      std::cerr << "warning: ignoring malformed entry in tuning file \""
+                << file_name << "\"" << std::endl;
+      continue;
+    }
+    blocking = b;
+    return true;
+  }
+  return false;
+}
+
+void tuning_cache::store(const tuning_key &key,
+                         const memory_layout::blocking_configuration &b,
+                         double gflops) const {
+  std::string prefix = detail::key_prefix(key);
+  std::vector<std::string> lines;
+  {
+    std::ifstream f(file_name);
+    std::string line;
+    while (std::getline(f, line)) {
+      if (line.compare(0, prefix.size(), prefix) != 0) {
+        lines.push_back(line);
+      }
+    }
+  }
+  std::ofstream f(file_name, std::ios::trunc);
+  for (const std::string &line : lines) {
+    f << line << std::endl;
+  }
+  f << prefix << b.L3_X << " " << b.L3_Y << " " << b.L3_K_STEP << " "
+    << b.L2_X << " " << b.L2_Y << " " << b.L2_K_STEP << " " << b.L1_X << " "
+    << b.L1_Y << " " << b.L1_K_STEP << " " << b.X_REG << " " << b.Y_REG << "\t"
+    << gflops << std::endl;
+  if (!f) {
+    std::cerr << "warning: could not write tuning file \"" << file_name << "\""
+              << std::endl;
+  }
+}
+
+autotuner::autotuner(
+    std::function<double(const memory_layout::blocking_configuration &)>
+        benchmark,
+    const std::vector<std::pair<size_t, size_t>> &register_shapes,
+    uint64_t verbose)
+    : benchmark(benchmark), register_shapes(register_shapes),
+      verbose(verbose) {}
+
+memory_layout::blocking_configuration
+autotuner::tune(const memory_layout::blocking_configuration &start,
+                double &best_gflops) {
+  start.verify();
+
+  // the start shape is always part of the search space
+  size_t start_shape_index = register_shapes.size();
+  for (size_t i = 0; i < register_shapes.size(); i++) {
+    if (register_shapes[i] == std::make_pair(start.X_REG, start.Y_REG)) {
+      start_shape_index = i;
+    }
+  }
+  if (start_shape_index == register_shapes.size()) {
+    register_shapes.push_back(std::make_pair(start.X_REG, start.Y_REG));
+  }
+  std::vector<size_t> shape_candidates;
+  for (size_t i = 0; i < register_shapes.size(); i++) {
+    shape_candidates.push_back(i);
+  }
+
+  // every configuration is only benchmarked once
+  std::map<detail::factors, double> evaluated;
+  auto evaluate = [this, &evaluated](const detail::factors &f) {
+    auto it = evaluated.find(f);
+    if (it != evaluated.end()) {
+      return it->second;
+    }
+    memory_layout::blocking_configuration b =
+        detail::to_blocking(f, register_shapes);
+    double gflops = benchmark(b);
+    if (verbose >= 1) {
+      std::cout << "autotuner: " << b << " -> " << gflops << "Gflops"
+                << std::endl;
+    }
+    evaluated[f] = gflops;
+    return gflops;
+  };
+
+  detail::factors best = detail::to_factors(start, start_shape_index);
+  best_gflops = evaluate(best);
+
+  // optimize one dimension at a time, starting with the register and L1
+  // blocking, until no dimension can be improved any further
+  bool improved = true;
+  for (size_t pass = 0; improved && pass < 3; pass++) {
+    improved = false;
+    for (size_t d = 0; d < best.size(); d++) {
+      const std::vector<size_t> &dim_candidates =
+          d == 0 ? shape_candidates : detail::candidates[d - 1];
+      for (size_t candidate : dim_candidates) {
+        detail::factors f = best;
+        if (d == 0) {
+          f = detail::change_shape(best, candidate, register_shapes);
+        } else {
+          f[d] = candidate;
+        }
+        double gflops = evaluate(f);
+        if (gflops > best_gflops) {
+          best_gflops = gflops;
+          best = f;
+          improved = true;
+        }
+      }
+    }
+  }
+
+  memory_layout::blocking_configuration result =
+      detail::to_blocking(best, register_shapes);
+  std::cout << "autotuner: best blocking " << result << " (" << best_gflops
+            << "Gflops, " << evaluated.size() << " configurations evaluated)"
+            << std::endl;
+  return result;
+}
+}
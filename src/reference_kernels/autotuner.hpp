@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory_layout/blocking_configuration.hpp"
+
+namespace autotuner {
+
+// identifies the machine and problem a blocking configuration was tuned for
+struct tuning_key {
+  std::string cpu_model;
+  // instruction set of the micro kernels, the register shapes and cache tiles
+  // that are best differ between them
+  std::string isa;
+  std::string algorithm;
+  size_t threads;
+  size_t size_class;
+};
+
+// model name of the first processor as reported by /proc/cpuinfo
+std::string get_cpu_model();
+
+// matrices are grouped into size classes (next power of two), so that a
+// tuning result can be reused for similarly sized problems
+size_t get_size_class(size_t N);
+
+// key for this machine and the active instruction set (micro_kernel::get_isa)
+tuning_key make_tuning_key(const std::string &algorithm, size_t threads,
+                           size_t N);
+
+// plain text file, one tab-separated line per tuning_key
+class tuning_cache {
+private:
+  std::string file_name;
+
+public:
+  tuning_cache(const std::string &file_name);
+
+  // returns true and sets blocking if an entry for key was found
+  bool lookup(const tuning_key &key,
+              memory_layout::blocking_configuration &blocking) const;
+
+  // adds or replaces the entry for key
+  void store(const tuning_key &key,
+             const memory_layout::blocking_configuration &blocking,
+             double gflops) const;
+};
+
+// coordinate descent over the register shapes and the L1/L2/L3 blocking space,
+// the benchmark function has to return the Gflops achieved with the given
+// blocking
+class autotuner {
+private:
+  std::function<double(const memory_layout::blocking_configuration &)>
+      benchmark;
+  std::vector<std::pair<size_t, size_t>> register_shapes;
+  uint64_t verbose;
+
+public:
+  autotuner(std::function<double(const memory_layout::blocking_configuration &)>
+                benchmark,
+            const std::vector<std::pair<size_t, size_t>> &register_shapes,
+            uint64_t verbose);
+
+  memory_layout::blocking_configuration
+  tune(const memory_layout::blocking_configuration &start, double &best_gflops);
+};
+}
@@ -1,7 +1,13 @@
 #include "kernel_test.hpp"
 
+#include <chrono>
+#include <iostream>
+
 #include <Vc/Vc>
-#include <boost/align/aligned_allocator.hpp>
+
+#include "memory_layout/page_allocator.hpp"
+#include "roofline.hpp"
+#include "util/perf_counters.hpp"
 
 #define PADDING 64
 #define L3_X 256 // max 2 L3 par set to 1024 (rest 512)
@@ -25,36 +31,54 @@ kernel_test::kernel_test(size_t N, std::vector<double> &A,
 
 std::vector<double> kernel_test::matrix_multiply() {
 
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> C_padded(
-      (N + PADDING) * (N + PADDING));
+  // fresh pages are zero, the padding doesn't have to be cleared
+  memory_layout::page_vector<double> C_padded((N + PADDING) * (N + PADDING));
 
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> A_padded(
-      (N + PADDING) * (N + PADDING));
-  for (size_t i = 0; i < N; i++) {
-    for (size_t j = 0; j < N; j++) {
-      A_padded[i * (N + PADDING) + j] = A[i * N + j];
+  memory_layout::page_vector<double> A_padded((N + PADDING) * (N + PADDING));
+  // is also padded if padding is enabled
+  memory_layout::page_vector<double> A_trans((N + PADDING) * (N + PADDING));
+  memory_layout::page_vector<double> B_padded((N + PADDING) * (N + PADDING));
+  {
+    util::perf_phase phase("kernel_test packing");
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+      for (size_t j = 0; j < N; j++) {
+        A_padded[i * (N + PADDING) + j] = A[i * N + j];
+      }
     }
-  }
 
-  // is also padded if padding is enabled
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> A_trans(
-      (N + PADDING) * (N + PADDING));
-  for (size_t i = 0; i < N; i++) {
-    for (size_t j = 0; j < N; j++) {
-      A_trans[i * (N + PADDING) + j] = A[j * N + i];
+    for (size_t i = 0; i < N; i++) {
+      for (size_t j = 0; j < N; j++) {
+        A_trans[i * (N + PADDING) + j] = A[j * N + i];
+      }
     }
-  }
 
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> B_padded(
-      (N + PADDING) * (N + PADDING));
-  for (size_t i = 0; i < N; i++) {
-    for (size_t j = 0; j < N; j++) {
-      B_padded[i * (N + PADDING) + j] = B[i * N + j];
+    for (size_t i = 0; i < N; i++) {
+      for (size_t j = 0; j < N; j++) {
+        B_padded[i * (N + PADDING) + j] = B[i * N + j];
+      }
     }
+    std::chrono::high_resolution_clock::time_point end =
+        std::chrono::high_resolution_clock::now();
+    // three N x N copies, only the written part of the padded matrices
+    roofline::record_bandwidth(
+        "kernel_test packing",
+        6.0 * static_cast<double>(N * N) * sizeof(double),
+        std::chrono::duration<double>(end - start).count());
+  }
+
+  if (verbose >= 1) {
+    std::cout << "padded matrices backed by "
+              << memory_layout::to_string(
+                     memory_layout::get_page_backing(A_trans.data()))
+              << std::endl;
   }
 
   for (size_t rep = 0; rep < repetitions; rep++) {
 
+    util::perf_phase phase("kernel_test compute");
+
     std::fill(C_padded.begin(), C_padded.end(), 0.0);
 
     using Vc::double_v;
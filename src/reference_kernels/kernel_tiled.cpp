@@ -1,559 +1,463 @@
 #include "kernel_tiled.hpp"
 
+#include <algorithm>
 #include <chrono>
 
-#include <Vc/Vc>
-#include <boost/align/aligned_allocator.hpp>
-
-// best parameters
-// #define L3_X 420 // max 2 L3 par set to 1024 (rest 512)
-// #define L3_Y 256
-// #define L3_K_STEP 512
-#define L3_X 420 // max 2 L3 par set to 1024 (rest 512)
-#define L3_Y 256
-#define L3_K_STEP 256
-
-// parameters for kernel tuning
-// #define L3_X 70 // max 2 L3 par set to 1024 (rest 512)
-// #define L3_Y 64
-// #define L3_K_STEP 64
-#define L2_X 70 // max 2 L2 par set to 128 (rest 64)
-#define L2_Y 64
-#define L2_K_STEP 128
-#define L1_X 35 // max all L1 par set to 32
-#define L1_Y 16
-#define L1_K_STEP 64
-#define X_REG 5 // cannot be changed!
-#define Y_REG 8 // cannot be changed!
-#define K_REG 1 // cannot be changed!
-
-// 4x12 approach kernel tuning
-// #define L3_X 32 // max 2 L3 par set to 1024 (rest 512)
-// #define L3_Y 24
-// #define L3_K_STEP 32
-// #define L2_X 32 // max 2 L2 par set to 128 (rest 64)
-// #define L2_Y 24
-// #define L2_K_STEP 32
-// #define L1_X 32 // max all L1 par set to 32
-// #define L1_Y 24
-// #define L1_K_STEP 32
-// #define X_REG 4 // cannot be changed!
-// #define Y_REG 12 // cannot be changed!
-// #define K_REG 1 // cannot be changed!
+#include <omp.h>
+
+#include "memory_layout/memory_layout_exception.hpp"
+#include "memory_layout/numa.hpp"
+#include "memory_layout/packing.hpp"
+#include "micro_kernel.hpp"
+#include "roofline.hpp"
+#include "util/perf_counters.hpp"
+
+using memory_layout::packing::operand_tile_base;
+using memory_layout::packing::result_tile_base;
+using memory_layout::packing::tile_extent;
 
 namespace kernel_tiled {
 
-void kernel_tiled::verify_blocking_setup() {
-  if (!((L2_X % L1_X == 0) && (L3_X % L2_X == 0))) {
-    std::cout << "error: x direction blocking not set up correctly"
-              << std::endl;
-    throw;
+namespace {
+
+// smallest multiple of block that is at least N
+size_t pad_to(size_t N, size_t block) {
+  return ((N + block - 1) / block) * block;
+}
+
+// a tile that reaches into the padding of the operands can't be written to C
+// directly, it is computed into a buffer and the part inside of C is merged
+template <typename T>
+void edge_tile(micro_kernel::l1_kernel_type<T> kernel, const T *A_trans,
+               const T *B, size_t x_extent, size_t y_extent, size_t k_extent,
+               T alpha, T beta, T *C, size_t ldc, size_t x_count,
+               size_t y_count) {
+  static thread_local aligned_vector<T> buffer;
+  if (buffer.size() < x_extent * y_extent) {
+    buffer.resize(x_extent * y_extent);
   }
-  if (!((L2_Y % L1_Y == 0) && (L3_Y % L2_Y == 0))) {
-    std::cout << "error: y direction blocking not set up correctly"
-              << std::endl;
-    throw;
+  kernel(A_trans, B, buffer.data(), y_extent, x_extent, y_extent, k_extent,
+         alpha, T(0));
+  for (size_t x = 0; x < x_count; x++) {
+    for (size_t y = 0; y < y_count; y++) {
+      T &c = C[x * ldc + y];
+      c = (beta == T(0) ? T(0) : beta * c) + buffer[x * y_extent + y];
+    }
   }
-  if (!((L2_K_STEP % L1_K_STEP == 0) && (L3_K_STEP % L2_K_STEP == 0))) {
-    std::cout << "error: k direction blocking not set up correctly"
-              << std::endl;
-    throw;
+}
+
+// calls f for the tiles 0, ..., tiles - 1 in parallel, with the static
+// schedule every thread gets a contiguous chunk, with work stealing the same
+// chunks are only the initial assignment
+template <typename F>
+void parallel_for_tiles(memory_layout::tile_schedule schedule, size_t tiles,
+                        F f) {
+  if (schedule == memory_layout::tile_schedule::static_schedule) {
+#pragma omp parallel for schedule(static)
+    for (size_t tile = 0; tile < tiles; tile++) {
+      f(tile);
+    }
+  } else {
+    // if the team is smaller than requested, the chunks of the missing
+    // threads are stolen
+    memory_layout::tile_scheduler scheduler(tiles, omp_get_max_threads());
+#pragma omp parallel num_threads(scheduler.get_workers())
+    {
+      size_t tile;
+      while (scheduler.next(omp_get_thread_num(), tile)) {
+        f(tile);
+      }
+    }
   }
 }
+}
 
-kernel_tiled::kernel_tiled(size_t N, std::vector<double> &A_org,
-                           std::vector<double> &B_org, bool transposed,
-                           uint64_t repetitions, uint64_t verbose)
-    : N_org(N), repetitions(repetitions), verbose(verbose) {
-  verify_blocking_setup();
+template <typename T>
+packed_operand<T>::packed_operand(
+    operand_side side, size_t outer_org, size_t K_org,
+    const memory_layout::blocking_configuration &blocking)
+    : side(side), outer_org(outer_org), K_org(K_org), blocking(blocking),
+      packing_bytes(0.0), packing_duration(0.0) {
+  blocking.verify();
+  // throws if there is no kernel for the register blocking
+  micro_kernel::select<T>(blocking.X_REG, blocking.Y_REG);
+  // only padded to the register blocking, the micro kernels handle the
+  // smaller tiles at the edges, k is never padded
+  outer_size = pad_to(outer_org, side == operand_side::A ? blocking.X_REG
+                                                         : blocking.Y_REG);
+  K_size = K_org;
+}
 
-  // k direction padding
-  size_t k_pad = L3_K_STEP - (N % L3_K_STEP);
-  if (k_pad == L3_K_STEP) {
-    k_pad = 0; // nothing to pad
-  }
-  size_t x_pad = L3_X - (N % L3_X);
-  if (x_pad == L3_X) {
-    x_pad = 0; // nothing to pad
-  }
-  size_t y_pad = L3_Y - (N % L3_Y);
-  if (y_pad == L3_Y) {
-    y_pad = 0; // nothing to pad
-  }
+template <typename T>
+packed_operand<T>
+pack_A(const T *A, size_t M, size_t K, size_t lda, bool transposed,
+       const memory_layout::blocking_configuration &blocking) {
+  packed_operand<T> packed(packed_operand<T>::operand_side::A, M, K,
+                           blocking);
+  const size_t X_size = packed.outer_size;
+  const size_t K_size = packed.K_size;
 
-  if (verbose >= 1) {
-    std::cout << "matrix padding: x_pad = " << x_pad << ", y_pad = " << y_pad
-              << ", k_pad = " << k_pad << std::endl;
-  }
+  // create a matrix of l1 cachable submatrices, caching by tiling, no large
+  // strides even without padding, the padding is filled with zeros, the
+  // buffer isn't initialized, its pages are first touched by the packing
+  // threads
+  util::perf_phase phase("kernel_tiled packing A");
+  auto A_trans =
+      std::make_shared<memory_layout::page_vector<T>>(K_size * X_size);
+  std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+  memory_layout::packing::pack_A<memory_layout::packing::openmp_policy>(
+      A, M, K, lda, transposed, A_trans->data(), X_size, K_size, blocking.L1_X,
+      blocking.L1_K_STEP);
+  std::chrono::high_resolution_clock::time_point end =
+      std::chrono::high_resolution_clock::now();
+  packed.packing_duration = std::chrono::duration<double>(end - start).count();
+  packed.packing_bytes =
+      static_cast<double>(M * K + X_size * K_size) * sizeof(T);
+  packed.tiles = A_trans;
+  return packed;
+}
+
+template <typename T>
+packed_operand<T>
+pack_B(const T *B, size_t K, size_t N, size_t ldb, bool transposed,
+       const memory_layout::blocking_configuration &blocking) {
+  packed_operand<T> packed(packed_operand<T>::operand_side::B, N, K,
+                           blocking);
+  const size_t Y_size = packed.outer_size;
+  const size_t K_size = packed.K_size;
+
+  util::perf_phase phase("kernel_tiled packing B");
+  auto B_padded =
+      std::make_shared<memory_layout::page_vector<T>>(K_size * Y_size);
+  std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+  memory_layout::packing::pack_B<memory_layout::packing::openmp_policy>(
+      B, K, N, ldb, transposed, B_padded->data(), Y_size, K_size, blocking.L1_Y,
+      blocking.L1_K_STEP);
+  std::chrono::high_resolution_clock::time_point end =
+      std::chrono::high_resolution_clock::now();
+  packed.packing_duration = std::chrono::duration<double>(end - start).count();
+  packed.packing_bytes =
+      static_cast<double>(K * N + Y_size * K_size) * sizeof(T);
+  packed.tiles = B_padded;
+  return packed;
+}
 
-  X_size = N + x_pad;
-  Y_size = N + y_pad;
-  K_size = N + k_pad;
+template <typename T>
+packed_operand<T>
+pack_A(size_t N, const std::vector<T> &A_org,
+       const memory_layout::blocking_configuration &blocking) {
+  return pack_A(A_org.data(), N, N, N, false, blocking);
+}
+
+template <typename T>
+packed_operand<T>
+pack_B(size_t N, const std::vector<T> &B_org,
+       const memory_layout::blocking_configuration &blocking) {
+  return pack_B(B_org.data(), N, N, N, false, blocking);
+}
+
+template <typename T>
+void gemm(bool transposed_A, bool transposed_B, size_t M, size_t N, size_t K,
+          T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta,
+          T *C, size_t ldc,
+          const memory_layout::blocking_configuration &blocking) {
+  kernel_tiled<T> m(pack_A(A, M, K, lda, transposed_A, blocking),
+                 pack_B(B, K, N, ldb, transposed_B, blocking), 1, 0);
+  util::perf_phase phase("kernel_tiled compute");
+  double duration = 0.0;
+  m.matrix_multiply(alpha, beta, C, ldc, duration);
+}
 
+template <typename T> void kernel_tiled<T>::print_padding() {
   if (verbose >= 1) {
+    std::cout << "blocking: " << blocking << std::endl;
+    std::cout << "matrix padding: x_pad = " << (X_size - X_org)
+              << ", y_pad = " << (Y_size - Y_org)
+              << ", k_pad = " << (K_size - K_org) << std::endl;
     std::cout << "matrix dimensions for calculation: X = " << X_size
               << ", Y = " << Y_size << ", K = " << K_size << std::endl;
+    if (!A_packed.tiles->empty() && !B_packed.tiles->empty()) {
+      std::cout << "packed A backed by "
+                << memory_layout::to_string(
+                       memory_layout::get_page_backing(A_packed.tiles->data()))
+                << ", packed B backed by "
+                << memory_layout::to_string(
+                       memory_layout::get_page_backing(B_packed.tiles->data()))
+                << std::endl;
+    }
   }
+}
 
-  A = std::vector<double>(X_size * K_size);
-  std::fill(A.begin(), A.end(), 0.0);
-  for (size_t x = 0; x < N_org; x++) {
-    for (size_t k = 0; k < N_org; k++) {
-      A.at(x * K_size + k) = A_org.at(x * N + k);
-    }
+template <typename T>
+kernel_tiled<T>::kernel_tiled(
+    size_t N, std::vector<T> &A_org, std::vector<T> &B_org,
+    bool transposed, uint64_t repetitions, uint64_t verbose,
+    const memory_layout::blocking_configuration &blocking)
+    : kernel_tiled(N, A_org.data(), B_org.data(), transposed, repetitions,
+                   verbose, blocking) {}
+
+template <typename T>
+kernel_tiled<T>::kernel_tiled(
+    size_t N, const T *A_org, const T *B_org, bool transposed,
+    uint64_t repetitions, uint64_t verbose,
+    const memory_layout::blocking_configuration &blocking)
+    : kernel_tiled(pack_A(A_org, N, N, N, false, blocking),
+                   pack_B(B_org, N, N, N, transposed, blocking), repetitions,
+                   verbose) {}
+
+template <typename T>
+kernel_tiled<T>::kernel_tiled(const packed_operand<T> &A_packed,
+                              const packed_operand<T> &B_packed,
+                              uint64_t repetitions, uint64_t verbose)
+    : X_org(A_packed.outer_org), Y_org(B_packed.outer_org),
+      K_org(A_packed.K_org), X_size(A_packed.outer_size),
+      Y_size(B_packed.outer_size), K_size(A_packed.K_size),
+      A_packed(A_packed), B_packed(B_packed), repetitions(repetitions),
+      verbose(verbose), blocking(A_packed.blocking),
+      schedule(memory_layout::get_tile_schedule()) {
+  if (A_packed.side != packed_operand<T>::operand_side::A ||
+      B_packed.side != packed_operand<T>::operand_side::B) {
+    throw memory_layout::memory_layout_exception(
+        "packed operands passed in the wrong order (use pack_A() and "
+        "pack_B())");
   }
-  B = std::vector<double>(K_size * Y_size);
-  std::fill(B.begin(), B.end(), 0.0);
-  for (size_t y = 0; y < N_org; y++) {
-    for (size_t k = 0; k < N_org; k++) {
-      B.at(k * Y_size + y) = B_org.at(k * N + y);
-    }
+  if (A_packed.K_org != B_packed.K_org ||
+      !(A_packed.blocking == B_packed.blocking)) {
+    throw memory_layout::memory_layout_exception(
+        "packed operands differ in the k dimension or blocking");
   }
+  print_padding();
 }
 
-std::vector<double> kernel_tiled::matrix_multiply(double &duration) {
-
-  // create a matrix of l1 cachable submatrices, caching by tiling, no large
-  // strides even without padding
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> C_padded(
-      X_size * Y_size);
-  std::fill(C_padded.begin(), C_padded.end(), 0.0);
+template <typename T>
+std::vector<T> kernel_tiled<T>::matrix_multiply(double &duration) {
+  std::vector<T> C_return(X_org * Y_org);
+  matrix_multiply(C_return.data(), Y_org, duration);
+  return C_return;
+}
 
-  // create a matrix of l1 cachable submatrices, caching by tiling, no large
-  // strides even without padding
-  // is also padded if padding is enabled (row padded only)
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> A_trans(
-      K_size * X_size);
-  for (size_t l1_x = 0; l1_x < X_size / L1_X; l1_x += 1) {
-    for (size_t l1_k = 0; l1_k < K_size / L1_K_STEP; l1_k += 1) {
-      size_t base_index = (L1_X * L1_K_STEP) *
-                          (l1_k * (X_size / L1_X) + l1_x); // look up submatrix
-      for (size_t x = 0; x < L1_X; x++) {
-        for (size_t k = 0; k < L1_K_STEP; k++) {
-          A_trans[base_index + k * L1_X + x] =
-              A[(l1_x * L1_X + x) * K_size + (l1_k * L1_K_STEP + k)];
-        }
-      }
-    }
+template <typename T>
+void kernel_tiled<T>::matrix_multiply(T *C, size_t ldc, double &duration) {
+  double duration_sum = 0.0;
+  repetition_durations.clear();
+  for (size_t rep = 0; rep < repetitions; rep++) {
+    // counters are opened before and printed after the timed region
+    util::perf_phase phase("kernel_tiled compute");
+    double repetition_duration = 0.0;
+    matrix_multiply(T(1), T(0), C, ldc, repetition_duration);
+    repetition_durations.push_back(repetition_duration);
+    duration_sum += repetition_duration;
   }
+  duration += duration_sum;
 
-  // don't need padding for B, no dependency to row count
-  std::vector<double, boost::alignment::aligned_allocator<double, 32>> B_padded(
-      K_size * Y_size);
-  for (size_t l1_y = 0; l1_y < (Y_size / L1_Y); l1_y += 1) {
-    for (size_t l1_k = 0; l1_k < (K_size / L1_K_STEP); l1_k += 1) {
-      size_t base_index = (L1_Y * L1_K_STEP) *
-                          (l1_k * (Y_size / L1_Y) + l1_y); // look up submatrix
-      for (size_t y = 0; y < L1_Y; y++) {
-        for (size_t k = 0; k < L1_K_STEP; k++) {
-          B_padded[base_index + k * L1_Y + y] =
-              B[(l1_k * L1_K_STEP + k) * Y_size + (l1_y * L1_Y + y)];
-        }
-      }
-    }
-  }
+  std::cout << "duration inner: " << duration << "s" << std::endl;
 
-  // std::cout << "A:" << std::endl;
-  // for (uint64_t x = 0; x < N; x++) {
-  //   for (uint64_t y = 0; y < N; y++) {
-  // 	if (y > 0) {
-  // 	  std::cout << ", ";
-  // 	}
-  // 	std::cout << A[x * N + y];
-  //   }
-  //   std::cout << std::endl;
-  // }
-  // std::cout << "A trans:" << std::endl;
-  // for (uint64_t x = 0; x < N; x++) {
-  //   for (uint64_t y = 0; y < N; y++) {
-  // 	if (y > 0) {
-  // 	  std::cout << ", ";
-  // 	}
-  // 	std::cout << A[y * N + x];
-  //   }
-  //   std::cout << std::endl;
-  // }
-
-  // std::cout << "A_trans (sub-matrices, DOESNT CONSIDER PADDING):" <<
-  // std::endl;
-  // size_t submatrix_index = 0;
-  // for (uint64_t k = 0; k < N * N; k++) {
-  //   if (submatrix_index < L1_X * L1_K_STEP) {
-  // 	if (submatrix_index < L1_X * L1_K_STEP) {
-  // 	  if (submatrix_index > 0) {
-  // 	    std::cout << ", ";
-  // 	  }
-  // 	  std::cout << A_trans[k];
-  // 	}
-  // 	submatrix_index++;
-  //   } else {
-  // 	submatrix_index = 1;
-  // 	std::cout << std::endl;
-  // 	std::cout << A_trans[k];
-  //   }
-  // }
-  // std::cout << std::endl;
-
-  // std::cout << "B:" << std::endl;
-  // for (uint64_t x = 0; x < N; x++) {
-  //   for (uint64_t y = 0; y < N; y++) {
-  // 	if (y > 0) {
-  // 	  std::cout << ", ";
-  // 	}
-  // 	std::cout << B[x * N + y];
-  //   }
-  //   std::cout << std::endl;
-  // }
-
-  // std::cout << "B_padded (sub-matrices, DOESNT CONSIDER PADDING):" <<
-  // std::endl;
-  // submatrix_index = 0;
-  // for (uint64_t k = 0; k < N * N; k++) {
-  //   if (submatrix_index < L1_Y * L1_K_STEP) {
-  // 	if (submatrix_index < L1_Y * L1_K_STEP) {
-  // 	  if (submatrix_index > 0) {
-  // 	    std::cout << ", ";
-  // 	  }
-  // 	  std::cout << B_padded[k];
-  // 	}
-  // 	submatrix_index++;
-  //   } else {
-  // 	submatrix_index = 1;
-  // 	std::cout << std::endl;
-  // 	std::cout << B_padded[k];
-  //   }
-  // }
-  // std::cout << std::endl;
+  double flops = 2 * static_cast<double>(X_org) * static_cast<double>(Y_org) *
+                 static_cast<double>(K_org);
+  double gflop = flops / 1E9;
+  std::cout << "[X_size = " << X_size << ", Y_size = " << Y_size
+            << ", K_size = " << K_size
+            << "] inner performance: " << (repetitions * gflop / duration_sum)
+            << "Gflops (average across repetitions)" << std::endl;
 
-  for (size_t rep = 0; rep < repetitions; rep++) {
+  roofline::record_bandwidth("kernel_tiled packing A", A_packed.packing_bytes,
+                             A_packed.packing_duration);
+  roofline::record_bandwidth("kernel_tiled packing B", B_packed.packing_bytes,
+                             B_packed.packing_duration);
+
+  if (verbose >= 1) {
+    std::cout << "tile schedule: " << memory_layout::to_string(schedule)
+              << std::endl;
+    memory_layout::numa::print_node_bandwidth(
+        "packed A", A_packed.tiles->data(), A_packed.tiles->size() * sizeof(T));
+    memory_layout::numa::print_node_bandwidth(
+        "packed B", B_packed.tiles->data(), B_packed.tiles->size() * sizeof(T));
+  }
+}
 
-    std::fill(C_padded.begin(), C_padded.end(), 0.0);
-
-    std::chrono::high_resolution_clock::time_point start =
-        std::chrono::high_resolution_clock::now();
-
-    using Vc::double_v;
-// L3 blocking and parallelization
-#pragma omp parallel for collapse(2)
-    for (size_t l3_x = 0; l3_x < X_size; l3_x += L3_X) {
-      for (size_t l3_y = 0; l3_y < Y_size; l3_y += L3_Y) {
-        for (size_t l3_k = 0; l3_k < K_size; l3_k += L3_K_STEP) {
-          // L2 blocking
-          for (size_t l2_x = l3_x; l2_x < l3_x + L3_X; l2_x += L2_X) {
-            for (size_t l2_y = l3_y; l2_y < l3_y + L3_Y; l2_y += L2_Y) {
-              for (size_t l2_k = l3_k; l2_k < l3_k + L3_K_STEP;
-                   l2_k += L2_K_STEP) {
-                // L1 blocking
-                for (size_t l1_x = l2_x; l1_x < l2_x + L2_X; l1_x += L1_X) {
-                  size_t l1_block_x = l1_x / L1_X;
-                  for (size_t l1_y = l2_y; l1_y < l2_y + L2_Y; l1_y += L1_Y) {
-                    size_t l1_block_y = l1_y / L1_Y;
-                    size_t C_base_index =
-                        (L1_X * L1_Y) *
-                        (l1_block_x * (Y_size / L1_Y) + l1_block_y);
-                    for (size_t l1_k = l2_k; l1_k < l2_k + L2_K_STEP;
-                         l1_k += L1_K_STEP) {
-                      size_t l1_block_k = l1_k / L1_K_STEP;
-                      size_t A_base_index =
-                          (L1_X * L1_K_STEP) *
-                          (l1_block_k * (X_size / L1_X) + l1_block_x);
-                      size_t B_base_index =
-                          (L1_Y * L1_K_STEP) *
-                          (l1_block_k * (Y_size / L1_Y) + l1_block_y);
-                      // Register blocking
-                      for (size_t x = 0; x < L1_X; x += X_REG) {
-                        for (size_t y = 0; y < L1_Y; y += Y_REG) {
-
-                          double_v acc_11 = 0.0;
-                          double_v acc_21 = 0.0;
-                          double_v acc_31 = 0.0;
-                          double_v acc_41 = 0.0;
-
-                          double_v acc_51 = 0.0;
-
-                          double_v acc_12 = 0.0;
-                          double_v acc_22 = 0.0;
-                          double_v acc_32 = 0.0;
-                          double_v acc_42 = 0.0;
-
-                          double_v acc_52 = 0.0;
-
-                          // comment in for 4x12 approach
-                          // double_v acc_11 = 0.0;
-                          // double_v acc_21 = 0.0;
-                          // double_v acc_31 = 0.0;
-                          // double_v acc_41 = 0.0;
-
-                          // double_v acc_12 = 0.0;
-                          // double_v acc_22 = 0.0;
-                          // double_v acc_32 = 0.0;
-                          // double_v acc_42 = 0.0;
-
-                          // double_v acc_13 = 0.0;
-                          // double_v acc_23 = 0.0;
-                          // double_v acc_33 = 0.0;
-                          // double_v acc_43 = 0.0;
-
-                          for (size_t k_inner = 0; k_inner < L1_K_STEP;
-                               k_inner += 1) {
-
-                            double_v b_temp_1 = double_v(
-                                &B_padded[B_base_index + k_inner * L1_Y + y],
-                                Vc::flags::vector_aligned);
-                            double_v b_temp_2 =
-                                double_v(&B_padded[B_base_index +
-                                                   k_inner * L1_Y + (y + 4)],
-                                         Vc::flags::vector_aligned);
-
-                            double_v a_temp_1 =
-                                A_trans[A_base_index + k_inner * L1_X +
-                                        (x + 0)];
-                            double_v a_temp_2 =
-                                A_trans[A_base_index + k_inner * L1_X +
-                                        (x + 1)];
-                            double_v a_temp_3 =
-                                A_trans[A_base_index + k_inner * L1_X +
-                                        (x + 2)];
-
-                            acc_11 += a_temp_1 * b_temp_1;
-                            acc_21 += a_temp_2 * b_temp_1;
-
-                            acc_12 += a_temp_1 * b_temp_2;
-                            acc_22 += a_temp_2 * b_temp_2;
-
-                            double_v a_temp_4 =
-                                A_trans[A_base_index + k_inner * L1_X +
-                                        (x + 3)];
-                            double_v a_temp_5 =
-                                A_trans[A_base_index + k_inner * L1_X +
-                                        (x + 4)];
-
-                            acc_31 += a_temp_3 * b_temp_1;
-                            acc_32 += a_temp_3 * b_temp_2;
-
-                            acc_41 += a_temp_4 * b_temp_1;
-                            acc_51 += a_temp_5 * b_temp_1;
-
-                            acc_42 += a_temp_4 * b_temp_2;
-                            acc_52 += a_temp_5 * b_temp_2;
-
-                            // comment in for 4x12 approach
-                            // double_v b_temp_1 =
-                            //   double_v(&B_padded[B_base_index + k_inner *
-                            //   L1_Y + y], Vc::flags::vector_aligned);
-                            // double_v b_temp_2 =
-                            //   double_v(&B_padded[B_base_index + k_inner *
-                            //   L1_Y + (y + 4)], Vc::flags::vector_aligned);
-                            // double_v b_temp_3 =
-                            //   double_v(&B_padded[B_base_index + k_inner *
-                            //   L1_Y + (y + 8)], Vc::flags::vector_aligned);
-
-                            // double_v a_temp_1 = A_trans[A_base_index +
-                            // k_inner * L1_X + (x + 0)];
-                            // double_v a_temp_2 = A_trans[A_base_index +
-                            // k_inner * L1_X + (x + 1)];
-                            // double_v a_temp_3 = A_trans[A_base_index +
-                            // k_inner * L1_X + (x + 2)];
-                            // double_v a_temp_4 = A_trans[A_base_index +
-                            // k_inner * L1_X + (x + 3)];
-
-                            // acc_11 += a_temp_1 * b_temp_1;
-                            // acc_12 += a_temp_1 * b_temp_2;
-                            // acc_13 += a_temp_1 * b_temp_3;
-
-                            // acc_21 += a_temp_2 * b_temp_1;
-                            // acc_22 += a_temp_2 * b_temp_2;
-                            // acc_23 += a_temp_2 * b_temp_3;
-
-                            // acc_31 += a_temp_3 * b_temp_1;
-                            // acc_32 += a_temp_3 * b_temp_2;
-                            // acc_33 += a_temp_3 * b_temp_3;
-
-                            // acc_41 += a_temp_4 * b_temp_1;
-                            // acc_42 += a_temp_4 * b_temp_2;
-                            // acc_43 += a_temp_4 * b_temp_3;
-                          }
-
-                          double_v res_11 = double_v(
-                              &C_padded[C_base_index + (x + 0) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          res_11 += acc_11;
-                          res_11.memstore(
-                              &C_padded[C_base_index + (x + 0) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          double_v res_21 = double_v(
-                              &C_padded[C_base_index + (x + 1) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          res_21 += acc_21;
-                          res_21.memstore(
-                              &C_padded[C_base_index + (x + 1) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          double_v res_31 = double_v(
-                              &C_padded[C_base_index + (x + 2) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          res_31 += acc_31;
-                          res_31.memstore(
-                              &C_padded[C_base_index + (x + 2) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          double_v res_41 = double_v(
-                              &C_padded[C_base_index + (x + 3) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          res_41 += acc_41;
-                          res_41.memstore(
-                              &C_padded[C_base_index + (x + 3) * L1_Y + y],
-                              Vc::flags::element_aligned);
-
-                          // has to be commented out for 4x12 approach
-                          double_v res_51 = double_v(
-                              &C_padded[C_base_index + (x + 4) * L1_Y + y],
-                              Vc::flags::element_aligned);
-                          res_51 += acc_51;
-                          res_51.memstore(
-                              &C_padded[C_base_index + (x + 4) * L1_Y + y],
-                              Vc::flags::element_aligned);
-
-                          double_v res_12 =
-                              double_v(&C_padded[C_base_index + (x + 0) * L1_Y +
-                                                 (y + 4)],
-                                       Vc::flags::element_aligned);
-                          res_12 += acc_12;
-                          res_12.memstore(&C_padded[C_base_index +
-                                                    (x + 0) * L1_Y + (y + 4)],
-                                          Vc::flags::element_aligned);
-                          double_v res_22 =
-                              double_v(&C_padded[C_base_index + (x + 1) * L1_Y +
-                                                 (y + 4)],
-                                       Vc::flags::element_aligned);
-                          res_22 += acc_22;
-                          res_22.memstore(&C_padded[C_base_index +
-                                                    (x + 1) * L1_Y + (y + 4)],
-                                          Vc::flags::element_aligned);
-                          double_v res_32 =
-                              double_v(&C_padded[C_base_index + (x + 2) * L1_Y +
-                                                 (y + 4)],
-                                       Vc::flags::element_aligned);
-                          res_32 += acc_32;
-                          res_32.memstore(&C_padded[C_base_index +
-                                                    (x + 2) * L1_Y + (y + 4)],
-                                          Vc::flags::element_aligned);
-                          double_v res_42 =
-                              double_v(&C_padded[C_base_index + (x + 3) * L1_Y +
-                                                 (y + 4)],
-                                       Vc::flags::element_aligned);
-                          res_42 += acc_42;
-                          res_42.memstore(&C_padded[C_base_index +
-                                                    (x + 3) * L1_Y + (y + 4)],
-                                          Vc::flags::element_aligned);
-
-                          // has to be commented out for 4x12 approach
-                          double_v res_52 =
-                              double_v(&C_padded[C_base_index + (x + 4) * L1_Y +
-                                                 (y + 4)],
-                                       Vc::flags::element_aligned);
-                          res_52 += acc_52;
-                          res_52.memstore(&C_padded[C_base_index +
-                                                    (x + 4) * L1_Y + (y + 4)],
-                                          Vc::flags::element_aligned);
-
-                          // has to be commented in for 4x12 approach
-                          // double_v res_13 = double_v(&C_padded[C_base_index +
-                          // (x + 0) * L1_Y + (y + 8)]);
-                          // res_13 += acc_13;
-                          // res_13.memstore(&C_padded[C_base_index + (x + 0) *
-                          // L1_Y + (y + 8)]);
-                          // double_v res_23 = double_v(&C_padded[C_base_index +
-                          // (x + 1) * L1_Y + (y + 8)]);
-                          // res_23 += acc_23;
-                          // res_23.memstore(&C_padded[C_base_index + (x + 1) *
-                          // L1_Y + (y + 8)]);
-                          // double_v res_33 = double_v(&C_padded[C_base_index +
-                          // (x + 2) * L1_Y + (y + 8)]);
-                          // res_33 += acc_33;
-                          // res_33.memstore(&C_padded[C_base_index + (x + 2) *
-                          // L1_Y + (y + 8)]);
-                          // double_v res_43 = double_v(&C_padded[C_base_index +
-                          // (x + 3) * L1_Y + (y + 8)]);
-                          // res_43 += acc_43;
-                          // res_43.memstore(&C_padded[C_base_index + (x + 3) *
-                          // L1_Y + (y + 8)]);
-                        }
-                      }
-                    }
-                  }
-                }
+template <typename T>
+size_t kernel_tiled<T>::get_k_splits(size_t threads) const {
+  const size_t l3_tiles = ((X_size + blocking.L3_X - 1) / blocking.L3_X) *
+                          ((Y_size + blocking.L3_Y - 1) / blocking.L3_Y);
+  const size_t l2_k_blocks =
+      (K_size + blocking.L2_K_STEP - 1) / blocking.L2_K_STEP;
+  if (l3_tiles >= threads) {
+    return 1;
+  }
+  // every part gets at least one L2 k block
+  return std::max(static_cast<size_t>(1),
+                  std::min(threads / l3_tiles, l2_k_blocks));
+}
+
+template <typename T>
+void kernel_tiled<T>::multiply_l3_tile(micro_kernel::l1_kernel_type<T> kernel,
+                                       size_t l3_x, size_t l3_y,
+                                       size_t k_begin, size_t k_end, T alpha,
+                                       T beta, T *C, size_t ldc) {
+  // local copies, so that the compiler can keep them in registers
+  const size_t L3_X = blocking.L3_X;
+  const size_t L3_Y = blocking.L3_Y;
+  const size_t L3_K_STEP = blocking.L3_K_STEP;
+  const size_t L2_X = blocking.L2_X;
+  const size_t L2_Y = blocking.L2_Y;
+  const size_t L2_K_STEP = blocking.L2_K_STEP;
+  const size_t L1_X = blocking.L1_X;
+  const size_t L1_Y = blocking.L1_Y;
+
+  // operands are packed once, repeated multiplies only read the tiles
+  const auto &A_trans = *A_packed.tiles;
+  const auto &B_padded = *B_packed.tiles;
+
+  // the blocks at the upper edges are clipped
+  const size_t l3_x_end = std::min(l3_x + L3_X, X_size);
+  const size_t l3_y_end = std::min(l3_y + L3_Y, Y_size);
+  for (size_t l3_k = k_begin; l3_k < k_end; l3_k += L3_K_STEP) {
+    const size_t l3_k_end = std::min(l3_k + L3_K_STEP, k_end);
+    // L2 blocking
+    for (size_t l2_x = l3_x; l2_x < l3_x_end; l2_x += L2_X) {
+      const size_t l2_x_end = std::min(l2_x + L2_X, l3_x_end);
+      for (size_t l2_y = l3_y; l2_y < l3_y_end; l2_y += L2_Y) {
+        const size_t l2_y_end = std::min(l2_y + L2_Y, l3_y_end);
+        for (size_t l2_k = l3_k; l2_k < l3_k_end; l2_k += L2_K_STEP) {
+          // the micro kernel runs over the whole L2 k block, the C block
+          // of a register tile is loaded and stored once per L2 k block
+          const size_t k_extent = std::min(l2_k + L2_K_STEP, l3_k_end) - l2_k;
+          // beta is only applied by the first k block, it stores instead
+          // of accumulating, so C never has to be cleared
+          const T beta_step = l2_k == k_begin ? beta : T(1);
+          // L1 blocking
+          for (size_t l1_x = l2_x; l1_x < l2_x_end; l1_x += L1_X) {
+            size_t x_extent = tile_extent(l1_x, X_size, L1_X);
+            const T *A_tile =
+                &A_trans[operand_tile_base(l1_x, l2_k, X_size, K_size, L1_X)];
+            for (size_t l1_y = l2_y; l1_y < l2_y_end; l1_y += L1_Y) {
+              size_t y_extent = tile_extent(l1_y, Y_size, L1_Y);
+              const T *B_tile = &B_padded[operand_tile_base(
+                  l1_y, l2_k, Y_size, K_size, L1_Y)];
+              // C is written in place, only tiles in the padding need a
+              // buffer
+              bool inside =
+                  l1_x + x_extent <= X_org && l1_y + y_extent <= Y_org;
+              T *C_tile = &C[l1_x * ldc + l1_y];
+              if (inside) {
+                kernel(A_tile, B_tile, C_tile, ldc, x_extent, y_extent,
+                       k_extent, alpha, beta_step);
+              } else {
+                edge_tile(kernel, A_tile, B_tile, x_extent, y_extent,
+                          k_extent, alpha, beta_step, C_tile, ldc,
+                          std::min(x_extent, X_org - l1_x),
+                          std::min(y_extent, Y_org - l1_y));
               }
             }
           }
         }
       }
     }
-
-    std::chrono::high_resolution_clock::time_point end =
-        std::chrono::high_resolution_clock::now();
-    duration += std::chrono::duration<double>(end - start).count();
   }
+}
 
-  std::cout << "duration inner: " << duration << "s" << std::endl;
+template <typename T>
+void kernel_tiled<T>::matrix_multiply(T alpha, T beta, T *C, size_t ldc,
+                                      double &duration) {
+
+  const size_t L3_X = blocking.L3_X;
+  const size_t L3_Y = blocking.L3_Y;
+  const size_t L2_K_STEP = blocking.L2_K_STEP;
+  micro_kernel::l1_kernel_type<T> kernel =
+      micro_kernel::select<T>(blocking.X_REG, blocking.Y_REG);
+
+  const size_t blocks_x = (X_size + L3_X - 1) / L3_X;
+  const size_t blocks_y = (Y_size + L3_Y - 1) / L3_Y;
+  const size_t k_splits = get_k_splits(omp_get_max_threads());
+
+  std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+
+  if (K_size == 0) {
+    // no products to add, only scale C
+    for (size_t x = 0; x < X_org; x++) {
+      for (size_t y = 0; y < Y_org; y++) {
+        T &c = C[x * ldc + y];
+        c = beta == T(0) ? T(0) : beta * c;
+      }
+    }
+  } else if (k_splits == 1) {
+    // L3 blocking and parallelization, the tiles are numbered row by row
+    parallel_for_tiles(schedule, blocks_x * blocks_y, [&](size_t tile) {
+      multiply_l3_tile(kernel, (tile / blocks_y) * L3_X,
+                       (tile % blocks_y) * L3_Y, 0, K_size, alpha, beta, C,
+                       ldc);
+    });
+  } else {
+    // split-K: the first part of k is added to C directly, the others are
+    // computed into private buffers (not initialized, their first k block
+    // stores) and reduced afterwards, the parts are aligned to L2 k blocks
+    const size_t l2_k_blocks = (K_size + L2_K_STEP - 1) / L2_K_STEP;
+    std::vector<memory_layout::page_vector<T>> partial(k_splits - 1);
+#pragma omp parallel for schedule(static, 1)
+    for (size_t split = 1; split < k_splits; split++) {
+      partial[split - 1].resize(X_org * Y_org);
+    }
 
-  // std::cout << "C_padded result (sub-matrices, DOESNT CONSIDER PADDING):" <<
-  // std::endl;
-  // submatrix_index = 0;
-  // for (uint64_t k = 0; k < N * N; k++) {
-  //   if (submatrix_index < L1_Y * L1_X) {
-  // 	if (submatrix_index < L1_Y * L1_X) {
-  // 	  if (submatrix_index > 0) {
-  // 	    std::cout << ", ";
-  // 	  }
-  // 	  std::cout << C_padded[k];
-  // 	}
-  // 	submatrix_index++;
-  //   } else {
-  // 	submatrix_index = 1;
-  // 	std::cout << std::endl;
-  // 	std::cout << C_padded[k];
-  //   }
-  // }
-  // std::cout << std::endl;
-
-  std::vector<double> C_return(N_org * N_org);
-  std::fill(C_return.begin(), C_return.end(), 0.0);
-
-  for (size_t l1_x = 0; l1_x < X_size / L1_X; l1_x += 1) {
-    for (size_t l1_y = 0; l1_y < Y_size / L1_Y; l1_y += 1) {
-      size_t base_index =
-          (L1_X * L1_Y) * (l1_x * (Y_size / L1_Y) + l1_y); // look up submatrix
-      for (size_t x = 0; x < L1_X; x++) {
-        for (size_t y = 0; y < L1_Y; y++) {
-          // skip padding
-          if (l1_x * L1_X + x < N_org && l1_y * L1_Y + y < N_org) {
-            C_return.at((l1_x * L1_X + x) * N_org + (l1_y * L1_Y + y)) =
-                C_padded.at(base_index + x * L1_Y + y);
-          }
+    const size_t l3_tiles = blocks_x * blocks_y;
+    parallel_for_tiles(schedule, k_splits * l3_tiles, [&](size_t tile) {
+      const size_t split = tile / l3_tiles;
+      const size_t l3_x = ((tile % l3_tiles) / blocks_y) * L3_X;
+      const size_t l3_y = (tile % blocks_y) * L3_Y;
+      const size_t k_begin =
+          std::min(split * l2_k_blocks / k_splits * L2_K_STEP, K_size);
+      const size_t k_end =
+          std::min((split + 1) * l2_k_blocks / k_splits * L2_K_STEP, K_size);
+      if (split == 0) {
+        multiply_l3_tile(kernel, l3_x, l3_y, k_begin, k_end, alpha, beta, C,
+                         ldc);
+      } else {
+        multiply_l3_tile(kernel, l3_x, l3_y, k_begin, k_end, alpha, T(0),
+                         partial[split - 1].data(), Y_org);
+      }
+    });
+
+// parallel reduction of the partial products into C
+#pragma omp parallel for
+    for (size_t x = 0; x < X_org; x++) {
+      T *C_row = &C[x * ldc];
+      for (size_t split = 1; split < k_splits; split++) {
+        const T *partial_row = &partial[split - 1][x * Y_org];
+        for (size_t y = 0; y < Y_org; y++) {
+          C_row[y] += partial_row[y];
         }
       }
     }
   }
 
-  double flops = 2 * static_cast<double>(X_size) * static_cast<double>(Y_size) *
-                 static_cast<double>(K_size);
-  double gflop = flops / 1E9;
-  std::cout << "[X_size = " << X_size << ", Y_size = " << Y_size
-            << ", K_size = " << K_size
-            << "] inner performance: " << (repetitions * gflop / duration)
-            << "Gflops (average across repetitions)" << std::endl;
-
-  return C_return;
-}
+  std::chrono::high_resolution_clock::time_point end =
+      std::chrono::high_resolution_clock::now();
+  duration += std::chrono::duration<double>(end - start).count();
 }
 
-#undef L3_X
-#undef L3_Y
-#undef L3_K_STEP
-#undef L2_X
-#undef L2_Y
-#undef L2_K_STEP
-#undef L1_X
-#undef L1_Y
-#undef L1_K_STEP
-#undef X_REG
-#undef Y_REG
+#define INSTANTIATE_KERNEL_TILED(T)                                            \
+  template class packed_operand<T>;                                            \
+  template class kernel_tiled<T>;                                              \
+  template packed_operand<T> pack_A<T>(                                        \
+      const T *, size_t, size_t, size_t, bool,                                 \
+      const memory_layout::blocking_configuration &);                          \
+  template packed_operand<T> pack_B<T>(                                        \
+      const T *, size_t, size_t, size_t, bool,                                 \
+      const memory_layout::blocking_configuration &);                          \
+  template packed_operand<T> pack_A<T>(                                        \
+      size_t, const std::vector<T> &,                                          \
+      const memory_layout::blocking_configuration &);                          \
+  template packed_operand<T> pack_B<T>(                                        \
+      size_t, const std::vector<T> &,                                          \
+      const memory_layout::blocking_configuration &);                          \
+  template void gemm<T>(bool, bool, size_t, size_t, size_t, T, const T *,      \
+                        size_t, const T *, size_t, T, T *, size_t,             \
+                        const memory_layout::blocking_configuration &);
+
+INSTANTIATE_KERNEL_TILED(double)
+INSTANTIATE_KERNEL_TILED(float)
+
+#undef INSTANTIATE_KERNEL_TILED
+}
@@ -2,28 +2,196 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include <boost/align/aligned_allocator.hpp>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/page_allocator.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+#include "reference_kernels/micro_kernel.hpp"
+
 namespace kernel_tiled {
 
-class kernel_tiled {
+// the engine is templated on the element type and instantiated for double
+// and float, the micro kernels and the packing exist for both
+
+template <typename T> class kernel_tiled;
+template <typename T> class packed_operand;
+
+template <typename T>
+using aligned_vector =
+    std::vector<T, boost::alignment::aligned_allocator<T, 32>>;
+
+// pack the left operand op(A) (M x K) into transposed L1 tiles, A is
+// row-major with leading dimension lda and stored K x M if transposed
+template <typename T>
+packed_operand<T> pack_A(const T *A, size_t M, size_t K, size_t lda,
+                         bool transposed,
+                         const memory_layout::blocking_configuration &blocking =
+                             memory_layout::blocking_configuration());
+
+// pack the right operand op(B) (K x N) into L1 tiles, B is row-major with
+// leading dimension ldb and stored N x K if transposed
+template <typename T>
+packed_operand<T> pack_B(const T *B, size_t K, size_t N, size_t ldb,
+                         bool transposed,
+                         const memory_layout::blocking_configuration &blocking =
+                             memory_layout::blocking_configuration());
+
+// an operand packed into the padded, L1-tiled layout of kernel_tiled, cheap to
+// copy (the tiles are shared), create once with pack_A()/pack_B() and reuse it
+// for any number of multiplies with the same blocking
+template <typename T> class packed_operand {
 private:
-  std::size_t N_org;
+  friend class kernel_tiled<T>;
+  friend packed_operand
+  pack_A<T>(const T *A, size_t M, size_t K, size_t lda, bool transposed,
+            const memory_layout::blocking_configuration &);
+  friend packed_operand
+  pack_B<T>(const T *B, size_t K, size_t N, size_t ldb, bool transposed,
+            const memory_layout::blocking_configuration &);
+
+  enum class operand_side { A, B };
+
+  operand_side side;
+  // dimensions of op(A) (M x K) or op(B) (K x N), outer is M or N
+  size_t outer_org;
+  size_t K_org;
+  // padded dimensions
+  size_t outer_size;
+  size_t K_size;
+  memory_layout::blocking_configuration blocking;
+  // first-touched by the parallel packing, distributed over the NUMA nodes
+  std::shared_ptr<const memory_layout::page_vector<T>> tiles;
+
+  // bytes read and written by the packing and the time it took
+  double packing_bytes;
+  double packing_duration;
+
+  packed_operand(operand_side side, size_t outer_org, size_t K_org,
+                 const memory_layout::blocking_configuration &blocking);
+
+public:
+  // dimensions of the packed matrix op(A) or op(B)
+  size_t get_rows() const {
+    return side == operand_side::A ? outer_org : K_org;
+  }
+  size_t get_cols() const {
+    return side == operand_side::A ? K_org : outer_org;
+  }
+  const memory_layout::blocking_configuration &get_blocking() const {
+    return blocking;
+  }
+};
+
+// pack the row-major N x N left operand into transposed L1 tiles
+template <typename T>
+packed_operand<T> pack_A(size_t N, const std::vector<T> &A_org,
+                         const memory_layout::blocking_configuration &blocking =
+                             memory_layout::blocking_configuration());
+
+// pack the row-major N x N right operand into L1 tiles
+template <typename T>
+packed_operand<T> pack_B(size_t N, const std::vector<T> &B_org,
+                         const memory_layout::blocking_configuration &blocking =
+                             memory_layout::blocking_configuration());
+
+// C = alpha * op(A) * op(B) + beta * C, BLAS-style interface for row-major
+// matrices, op(A) is M x K, op(B) is K x N and C is M x N, C is written in
+// place (no padded copy)
+template <typename T>
+void gemm(bool transposed_A, bool transposed_B, size_t M, size_t N, size_t K,
+          T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta,
+          T *C, size_t ldc,
+          const memory_layout::blocking_configuration &blocking =
+              memory_layout::blocking_configuration());
+
+template <typename T> class kernel_tiled {
+private:
+  // dimensions of the product, op(A) is X_org x K_org, op(B) K_org x Y_org
+  std::size_t X_org;
+  std::size_t Y_org;
+  std::size_t K_org;
   std::size_t X_size;
   std::size_t Y_size;
   std::size_t K_size;
-  std::vector<double> A;
-  std::vector<double> B;
+  packed_operand<T> A_packed;
+  packed_operand<T> B_packed;
 
   uint64_t repetitions;
   uint64_t verbose;
 
-  void verify_blocking_setup();
+  memory_layout::blocking_configuration blocking;
+
+  // distribution of the L3 tiles of C over the threads
+  memory_layout::tile_schedule schedule;
+
+  // of the last matrix_multiply(double &)
+  std::vector<double> repetition_durations;
+
+  void print_padding();
+
+  // number of parts the k dimension is split into, more than one if there
+  // are fewer L3 tiles of C than threads and K is long enough
+  size_t get_k_splits(size_t threads) const;
+
+  // C block of the L3 tile starting at (l3_x, l3_y) for the k range
+  // [k_begin, k_end), beta is applied by the first k block
+  void multiply_l3_tile(micro_kernel::l1_kernel_type<T> kernel, size_t l3_x,
+                        size_t l3_y, size_t k_begin, size_t k_end, T alpha,
+                        T beta, T *C, size_t ldc);
 
 public:
-  kernel_tiled(size_t N, std::vector<double> &A_org, std::vector<double> &B_org,
-               bool transposed, uint64_t repetitions, uint64_t verbose);
+  // B_org is read in its transposed storage order if transposed, the
+  // transposition happens while packing
+  kernel_tiled(size_t N, std::vector<T> &A_org, std::vector<T> &B_org,
+               bool transposed, uint64_t repetitions, uint64_t verbose,
+               const memory_layout::blocking_configuration &blocking =
+                   memory_layout::blocking_configuration());
+
+  // packs directly from the row-major N x N matrices, e.g. memory-mapped
+  // files, no copy of the inputs is made
+  kernel_tiled(size_t N, const T *A_org, const T *B_org, bool transposed,
+               uint64_t repetitions, uint64_t verbose,
+               const memory_layout::blocking_configuration &blocking =
+                   memory_layout::blocking_configuration());
+
+  // multiplies already packed operands, no copy of the inputs is made, throws
+  // memory_layout_exception if the handles were packed with different
+  // k dimensions or blockings
+  kernel_tiled(const packed_operand<T> &A_packed,
+               const packed_operand<T> &B_packed, uint64_t repetitions,
+               uint64_t verbose);
+
+  // the schedule is initialized with memory_layout::get_tile_schedule()
+  void set_schedule(memory_layout::tile_schedule schedule) {
+    this->schedule = schedule;
+  }
+
+  // inner time of every repetition of the last matrix_multiply(double &)
+  const std::vector<double> &get_repetition_durations() const {
+    return repetition_durations;
+  }
+
+  // floating point operations including the padding that is computed
+  double get_padded_flops() const {
+    return 2.0 * static_cast<double>(X_size) * static_cast<double>(Y_size) *
+           static_cast<double>(K_size);
+  }
+
+  // returns the product (row-major, X_org x Y_org), repeated repetitions times
+  std::vector<T> matrix_multiply(double &duration);
+
+  // as above, but writes the product into C with leading dimension ldc
+  void matrix_multiply(T *C, size_t ldc, double &duration);
 
-  std::vector<double> matrix_multiply(double &duration);
+  // C = alpha * op(A) * op(B) + beta * C for a row-major C with leading
+  // dimension ldc, computed once (ignores repetitions), adds the time spent
+  // to duration; if C has fewer L3 tiles than there are threads, the k
+  // dimension is split as well, the threads compute partial products in
+  // private buffers that are added to C in parallel afterwards
+  void matrix_multiply(T alpha, T beta, T *C, size_t ldc, double &duration);
 };
 }
@@ -0,0 +1,147 @@
+#include "micro_kernel.hpp"
+
+#include "memory_layout/memory_layout_exception.hpp"
+
+namespace micro_kernel {
+
+namespace detail {
+
+isa &active_isa() {
+  static isa level = detect_isa();
+  return level;
+}
+
+bool is_supported(isa level) {
+  switch (level) {
+  case isa::avx2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case isa::avx:
+    return __builtin_cpu_supports("avx");
+  default:
+    return __builtin_cpu_supports("sse2");
+  }
+}
+
+template <typename T> std::vector<shape_entry<T>> make_shapes(isa level) {
+  shape_entry<T> entries[max_shapes];
+  size_t count;
+  switch (level) {
+  case isa::avx2:
+    count = avx2::fill_shapes(entries);
+    break;
+  case isa::avx:
+    count = avx::fill_shapes(entries);
+    break;
+  default:
+    count = sse2::fill_shapes(entries);
+  }
+  return std::vector<shape_entry<T>>(entries, entries + count);
+}
+
+template <typename T> const std::vector<shape_entry<T>> &get_shapes(isa level) {
+  static const std::vector<shape_entry<T>> shapes_sse2 =
+      make_shapes<T>(isa::sse2);
+  static const std::vector<shape_entry<T>> shapes_avx =
+      make_shapes<T>(isa::avx);
+  static const std::vector<shape_entry<T>> shapes_avx2 =
+      make_shapes<T>(isa::avx2);
+  switch (level) {
+  case isa::avx2:
+    return shapes_avx2;
+  case isa::avx:
+    return shapes_avx;
+  default:
+    return shapes_sse2;
+  }
+}
+}
+
+std::string to_string(isa level) {
+  switch (level) {
+  case isa::avx2:
+    return "avx2";
+  case isa::avx:
+    return "avx";
+  default:
+    return "sse2";
+  }
+}
+
+isa detect_isa() {
+  __builtin_cpu_init();
+  for (isa level : {isa::avx2, isa::avx}) {
+    if (detail::is_supported(level)) {
+      return level;
+    }
+  }
+  return isa::sse2;
+}
+
+isa get_isa() { return detail::active_isa(); }
+
+void set_isa(const std::string &level) {
+  if (level.compare("auto") == 0) {
+    detail::active_isa() = detect_isa();
+    return;
+  }
+  for (isa candidate : {isa::sse2, isa::avx, isa::avx2}) {
+    if (level.compare(to_string(candidate)) == 0) {
+      __builtin_cpu_init();
+      if (!detail::is_supported(candidate)) {
+        throw memory_layout::memory_layout_exception(
+            "instruction set \"" + level + "\" is not supported by this CPU");
+      }
+      detail::active_isa() = candidate;
+      return;
+    }
+  }
+  throw memory_layout::memory_layout_exception(
+      "unknown instruction set \"" + level +
+      "\", expected one of auto, sse2, avx, avx2");
+}
+
+template <typename T> l1_kernel_type<T> select(size_t X_REG, size_t Y_REG) {
+  for (const detail::shape_entry<T> &entry :
+       detail::get_shapes<T>(get_isa())) {
+    if (entry.X_REG == X_REG && entry.Y_REG == Y_REG) {
+      return entry.kernel;
+    }
+  }
+  throw memory_layout::memory_layout_exception(
+      "no micro kernel available for register blocking " +
+      std::to_string(X_REG) + "x" + std::to_string(Y_REG) + " (" +
+      to_string(get_isa()) + ", " + (sizeof(T) == 4 ? "float" : "double") +
+      ")");
+}
+
+template <typename T> std::vector<std::pair<size_t, size_t>> available_shapes() {
+  std::vector<std::pair<size_t, size_t>> shapes;
+  for (const detail::shape_entry<T> &entry :
+       detail::get_shapes<T>(get_isa())) {
+    shapes.push_back(std::make_pair(entry.X_REG, entry.Y_REG));
+  }
+  return shapes;
+}
+
+template <> std::string default_shape<double>() { return "5x8"; }
+
+template <> std::string default_shape<float>() { return "5x16"; }
+
+template <typename T> double fma_loop(size_t iterations) {
+  switch (get_isa()) {
+  case isa::avx2:
+    return detail::avx2::fma_loop(iterations, T(1E-3));
+  case isa::avx:
+    return detail::avx::fma_loop(iterations, T(1E-3));
+  default:
+    return detail::sse2::fma_loop(iterations, T(1E-3));
+  }
+}
+
+template l1_kernel_type<double> select<double>(size_t X_REG, size_t Y_REG);
+template l1_kernel_type<float> select<float>(size_t X_REG, size_t Y_REG);
+template std::vector<std::pair<size_t, size_t>> available_shapes<double>();
+template std::vector<std::pair<size_t, size_t>> available_shapes<float>();
+template double fma_loop<double>(size_t iterations);
+template double fma_loop<float>(size_t iterations);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace micro_kernel {
+
+// processes one L1 tile: C = alpha * A * B + beta * C with C (L1_X x L1_Y,
+// row-major, leading dimension ldc), A (L1_X x K, stored transposed, k-major)
+// and B (K x L1_Y, row-major), beta is applied when the result is stored, C
+// isn't read if beta is zero, T is double or float; the C block of a register
+// tile stays in registers for the whole k range, which is typically a full
+// L2 k block of a packed strip
+template <typename T>
+using l1_kernel_type = void (*)(const T *A_trans, const T *B, T *C,
+                                size_t ldc, size_t L1_X, size_t L1_Y, size_t K,
+                                T alpha, T beta);
+
+// instruction set levels the micro kernels are compiled for, every level is
+// a separate object file built with the respective compiler flags
+enum class isa { sse2, avx, avx2 };
+
+std::string to_string(isa level);
+
+// highest level supported by the CPU and OS (determined via cpuid)
+isa detect_isa();
+
+// level used by select(), defaults to detect_isa()
+isa get_isa();
+
+// "auto", "sse2", "avx" or "avx2", throws memory_layout_exception if the
+// level is unknown or not supported by this CPU
+void set_isa(const std::string &level);
+
+// returns the kernel instantiated for the register blocking X_REG x Y_REG and
+// the active instruction set, throws memory_layout_exception if there is no
+// such kernel for the vector width of that instruction set
+template <typename T = double>
+l1_kernel_type<T> select(size_t X_REG, size_t Y_REG);
+
+// register blockings (X_REG, Y_REG) that can be selected with the active
+// instruction set
+template <typename T = double>
+std::vector<std::pair<size_t, size_t>> available_shapes();
+
+// default register blocking of the element type, "5x8" for double and "5x16"
+// for float (two vectors of 8 floats with AVX)
+template <typename T = double> std::string default_shape();
+
+// register-only loop of independent multiply-adds (fused with avx2) on the
+// vectors of the active instruction set, returns the number of floating point
+// operations performed, measures the compute peak of a core
+template <typename T = double> double fma_loop(size_t iterations);
+
+namespace detail {
+
+template <typename T> struct shape_entry {
+  size_t X_REG;
+  size_t Y_REG;
+  l1_kernel_type<T> kernel;
+};
+
+// upper bound of the shapes of an instruction set
+const size_t max_shapes = 8;
+
+// implemented once per instruction set in micro_kernel_<isa>.cpp; fill_shapes
+// writes the shapes that fit the vector width to entries (max_shapes
+// elements) and returns their number, plain arrays instead of containers,
+// because every STL template instantiated in these objects would be emitted
+// as a weak symbol with instructions of that set, and the linker may pick
+// that copy for the whole program
+namespace sse2 {
+size_t fill_shapes(shape_entry<double> *entries);
+size_t fill_shapes(shape_entry<float> *entries);
+double fma_loop(size_t iterations, double increment);
+double fma_loop(size_t iterations, float increment);
+}
+namespace avx {
+size_t fill_shapes(shape_entry<double> *entries);
+size_t fill_shapes(shape_entry<float> *entries);
+double fma_loop(size_t iterations, double increment);
+double fma_loop(size_t iterations, float increment);
+}
+namespace avx2 {
+size_t fill_shapes(shape_entry<double> *entries);
+size_t fill_shapes(shape_entry<float> *entries);
+double fma_loop(size_t iterations, double increment);
+double fma_loop(size_t iterations, float increment);
+}
+}
+}
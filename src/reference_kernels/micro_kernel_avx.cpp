@@ -0,0 +1,8 @@
+// micro kernels for the avx instruction set, has to be compiled with
+// "-mavx" (see CMakeLists.txt and src/SConscript)
+#ifndef __AVX__
+#error "micro_kernel_avx.cpp has to be compiled with -mavx"
+#endif
+
+#define MICRO_KERNEL_ISA avx
+#include "micro_kernel_impl.hpp"
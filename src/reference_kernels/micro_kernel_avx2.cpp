@@ -0,0 +1,8 @@
+// micro kernels for the avx2 instruction set, has to be compiled with
+// "-mavx2 -mfma" (see CMakeLists.txt and src/SConscript)
+#if !defined(__AVX2__) || !defined(__FMA__)
+#error "micro_kernel_avx2.cpp has to be compiled with -mavx2 -mfma"
+#endif
+
+#define MICRO_KERNEL_ISA avx2
+#include "micro_kernel_impl.hpp"
@@ -0,0 +1,151 @@
+// included by the micro_kernel_<isa>.cpp files only, MICRO_KERNEL_ISA has to
+// be defined to the namespace of the instruction set, so that the template
+// instances of the different builds don't collide at link time
+
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include <Vc/Vc>
+
+#include "micro_kernel.hpp"
+
+#ifndef MICRO_KERNEL_ISA
+#error "MICRO_KERNEL_ISA has to be defined before including micro_kernel_impl.hpp"
+#endif
+
+namespace micro_kernel {
+namespace detail {
+namespace MICRO_KERNEL_ISA {
+
+// like std::integral_constant, but its conversion operator is code of this
+// namespace (it isn't always inlined)
+template <size_t value> struct index_constant {
+  constexpr operator size_t() const { return value; }
+};
+
+template <typename F, size_t... indices>
+inline void static_for_impl(F &&f, std::index_sequence<indices...>) {
+  (void)std::initializer_list<int>{(f(index_constant<indices>()), 0)...};
+}
+
+// calls f(0), ..., f(count - 1) with compile-time indices, so that the
+// accumulators below are addressed with constants and stay in registers
+template <size_t count, typename F> inline void static_for(F &&f) {
+  static_for_impl(f, std::make_index_sequence<count>());
+}
+
+// see l1_kernel_type, works in X_REG x Y_REG register blocks
+template <typename T, size_t X_REG, size_t Y_REG>
+void l1_kernel(const T *A_trans, const T *B, T *C, size_t ldc, size_t L1_X,
+               size_t L1_Y, size_t K, T alpha, T beta) {
+  using vector_t = Vc::Vector<T>;
+  constexpr size_t Y_VEC = Y_REG / vector_t::Size;
+  static_assert(Y_VEC * vector_t::Size == Y_REG,
+                "Y_REG has to be a multiple of the vector width");
+  const vector_t alpha_v = alpha;
+  const vector_t beta_v = beta;
+
+  for (size_t x = 0; x < L1_X; x += X_REG) {
+    for (size_t y = 0; y < L1_Y; y += Y_REG) {
+
+      vector_t acc[X_REG][Y_VEC];
+      static_for<X_REG>([&](auto i) {
+        static_for<Y_VEC>([&](auto j) { acc[i][j] = 0.0; });
+      });
+
+      for (size_t k_inner = 0; k_inner < K; k_inner += 1) {
+        vector_t b_temp[Y_VEC];
+        static_for<Y_VEC>([&](auto j) {
+          b_temp[j] = vector_t(&B[k_inner * L1_Y + y + j * vector_t::Size],
+                               Vc::flags::vector_aligned);
+        });
+        static_for<X_REG>([&](auto i) {
+          vector_t a_temp = A_trans[k_inner * L1_X + (x + i)];
+          static_for<Y_VEC>([&](auto j) { acc[i][j] += a_temp * b_temp[j]; });
+        });
+      }
+
+      // beta is applied while the tile of C is loaded anyway, no extra pass
+      static_for<X_REG>([&](auto i) {
+        static_for<Y_VEC>([&](auto j) {
+          T *c = &C[(x + i) * ldc + y + j * vector_t::Size];
+          vector_t res = alpha_v * acc[i][j];
+          if (beta != T(0)) {
+            res += beta_v * vector_t(c, Vc::flags::element_aligned);
+          }
+          res.memstore(c, Vc::flags::element_aligned);
+        });
+      });
+    }
+  }
+}
+
+// keeps the result of fma_loop from being optimized away
+volatile double fma_sink;
+
+// see micro_kernel::fma_loop, the accumulators are independent, so that the
+// latency of the multiply-adds is hidden like in the micro kernels
+template <typename T> double fma_loop_impl(size_t iterations, T increment) {
+  using vector_t = Vc::Vector<T>;
+  constexpr size_t accumulators = 12;
+  // below 1, the accumulators converge instead of overflowing
+  const vector_t factor = T(0.999);
+  const vector_t add = increment;
+  vector_t acc[accumulators];
+  static_for<accumulators>([&](auto i) { acc[i] = T(i); });
+  for (size_t it = 0; it < iterations; it++) {
+    static_for<accumulators>([&](auto i) { acc[i] = acc[i] * factor + add; });
+  }
+  vector_t sum = 0.0;
+  static_for<accumulators>([&](auto i) { sum += acc[i]; });
+  fma_sink = sum.sum();
+  return 2.0 * static_cast<double>(iterations) * accumulators *
+         vector_t::Size;
+}
+
+double fma_loop(size_t iterations, double increment) {
+  return fma_loop_impl<double>(iterations, increment);
+}
+
+double fma_loop(size_t iterations, float increment) {
+  return fma_loop_impl<float>(iterations, increment);
+}
+
+// shapes that don't fit the vector width of the build are not instantiated
+template <typename T, size_t X_REG, size_t Y_REG>
+typename std::enable_if<Y_REG % Vc::Vector<T>::Size == 0, size_t>::type
+add_shape(shape_entry<T> *entries, size_t count) {
+  entries[count].X_REG = X_REG;
+  entries[count].Y_REG = Y_REG;
+  entries[count].kernel = &l1_kernel<T, X_REG, Y_REG>;
+  return count + 1;
+}
+
+template <typename T, size_t X_REG, size_t Y_REG>
+typename std::enable_if<Y_REG % Vc::Vector<T>::Size != 0, size_t>::type
+add_shape(shape_entry<T> *, size_t count) {
+  return count;
+}
+
+size_t fill_shapes(shape_entry<double> *entries) {
+  size_t count = 0;
+  count = add_shape<double, 5, 8>(entries, count); // default, best on Skylake
+  count = add_shape<double, 4, 12>(entries, count);
+  count = add_shape<double, 6, 8>(entries, count);
+  count = add_shape<double, 8, 4>(entries, count);
+  return count;
+}
+
+// the same register tiles for 8-wide float vectors (AVX)
+size_t fill_shapes(shape_entry<float> *entries) {
+  size_t count = 0;
+  count = add_shape<float, 5, 16>(entries, count); // default
+  count = add_shape<float, 4, 24>(entries, count);
+  count = add_shape<float, 6, 16>(entries, count);
+  count = add_shape<float, 8, 8>(entries, count);
+  return count;
+}
+}
+}
+}
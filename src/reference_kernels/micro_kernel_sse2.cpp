@@ -0,0 +1,8 @@
+// micro kernels for the sse2 instruction set, has to be compiled with
+// "-msse2" (see CMakeLists.txt and src/SConscript)
+#ifndef __SSE2__
+#error "micro_kernel_sse2.cpp has to be compiled with -msse2"
+#endif
+
+#define MICRO_KERNEL_ISA sse2
+#include "micro_kernel_impl.hpp"
@@ -38,3 +38,25 @@ std::vector<T> naive_matrix_multiply_transposed(std::size_t N,
   }
   return C;
 }
+
+// C = alpha * op(A) * op(B) + beta * C for row-major matrices with leading
+// dimensions, op(A) is M x K, op(B) is K x N
+template <typename T>
+void naive_gemm(bool transposed_A, bool transposed_B, std::size_t M,
+                std::size_t N, std::size_t K, T alpha, const T *A,
+                std::size_t lda, const T *B, std::size_t ldb, T beta, T *C,
+                std::size_t ldc) {
+#pragma omp parallel for
+  for (uint64_t i = 0; i < M; i++) {
+    for (uint64_t j = 0; j < N; j++) {
+      T result_component = 0.0;
+      for (uint64_t k = 0; k < K; k++) {
+        T a = transposed_A ? A[k * lda + i] : A[i * lda + k];
+        T b = transposed_B ? B[j * ldb + k] : B[k * ldb + j];
+        result_component += a * b;
+      }
+      T &c = C[i * ldc + j];
+      c = alpha * result_component + (beta == T(0) ? T(0) : beta * c);
+    }
+  }
+}
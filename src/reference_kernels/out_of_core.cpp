@@ -0,0 +1,332 @@
+#include "out_of_core.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+
+#include "kernel_tiled.hpp"
+#include "roofline.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+#include "util/perf_counters.hpp"
+
+#include <omp.h>
+
+namespace out_of_core {
+
+namespace {
+
+size_t round_up(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// the panels of A and B of a tile, tile t of the row panel i is column panel
+// t on even and column panel (col_panels - 1 - t) on odd row panels
+struct tile_position {
+  size_t row_panel;
+  size_t col_panel;
+};
+
+tile_position get_tile(size_t tile, size_t col_panels) {
+  size_t row_panel = tile / col_panels;
+  size_t col_panel = tile % col_panels;
+  if (row_panel % 2 == 1) {
+    col_panel = col_panels - 1 - col_panel;
+  }
+  return {row_panel, col_panel};
+}
+
+// rows [row_begin, row_begin + rows) of A, the reads from the file happen
+// here, in the loader thread
+void read_A_panel(const double *A, size_t K, size_t row_begin, size_t rows,
+                  double *buffer) {
+  std::memcpy(buffer, A + row_begin * K, rows * K * sizeof(double));
+}
+
+// columns [col_begin, col_begin + cols) of op(B), row-major K x cols, or
+// cols x K if transposed
+void read_B_panel(const double *B, size_t N, size_t K, bool transposed,
+                  size_t col_begin, size_t cols, double *buffer) {
+  if (transposed) {
+    std::memcpy(buffer, B + col_begin * K, cols * K * sizeof(double));
+  } else {
+    for (size_t k = 0; k < K; k++) {
+      std::memcpy(buffer + k * cols, B + k * N + col_begin,
+                  cols * sizeof(double));
+    }
+  }
+}
+
+double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double>(
+             std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+}
+
+std::ostream &operator<<(std::ostream &out, const panel_shape &panels) {
+  out << panels.rows << "x" << panels.cols;
+  return out;
+}
+
+size_t buffer_bytes(const panel_shape &panels, size_t K,
+                    const memory_layout::blocking_configuration &blocking) {
+  size_t A_elements =
+      2 * panels.rows * K + round_up(panels.rows, blocking.X_REG) * K;
+  size_t B_elements =
+      2 * panels.cols * K + round_up(panels.cols, blocking.Y_REG) * K;
+  return (A_elements + B_elements) * sizeof(double);
+}
+
+panel_shape
+choose_panels(size_t M, size_t N, size_t K, size_t memory_budget,
+              size_t threads,
+              const memory_layout::blocking_configuration &blocking) {
+  size_t row_tiles = std::max<size_t>((M + blocking.L3_X - 1) / blocking.L3_X,
+                                      1);
+  size_t col_tiles = std::max<size_t>((N + blocking.L3_Y - 1) / blocking.L3_Y,
+                                      1);
+  auto shape = [&](size_t A_tiles, size_t B_tiles) {
+    return panel_shape{std::min(A_tiles * blocking.L3_X, M),
+                       std::min(B_tiles * blocking.L3_Y, N)};
+  };
+  auto fits = [&](size_t A_tiles, size_t B_tiles) {
+    return buffer_bytes(shape(A_tiles, B_tiles), K, blocking) <=
+           memory_budget;
+  };
+
+  // the A panel gets what is left after the B panel, three buffers of K
+  // elements per row, fewer rows if the padding of the packed copy doesn't
+  // fit anymore
+  auto fit_rows = [&](size_t B_tiles) {
+    size_t bytes_per_row = 3 * std::max<size_t>(K, 1) * sizeof(double);
+    size_t B_bytes = buffer_bytes(shape(0, B_tiles), K, blocking);
+    size_t A_tiles =
+        memory_budget > B_bytes
+            ? (memory_budget - B_bytes) / bytes_per_row / blocking.L3_X
+            : 0;
+    A_tiles = std::min(std::max<size_t>(A_tiles, 1), row_tiles);
+    while (A_tiles > 1 && !fits(A_tiles, B_tiles)) {
+      A_tiles--;
+    }
+    return A_tiles;
+  };
+
+  // fewest B tiles that give every thread an L3 tile of C, otherwise the
+  // most L3 tiles of C the budget allows
+  size_t B_tiles = 1;
+  size_t A_tiles = fit_rows(1);
+  for (size_t candidate = 2; A_tiles * B_tiles < threads &&
+                             candidate <= col_tiles && fits(1, candidate);
+       candidate++) {
+    size_t candidate_rows = fit_rows(candidate);
+    if (candidate_rows * candidate > A_tiles * B_tiles) {
+      A_tiles = candidate_rows;
+      B_tiles = candidate;
+    }
+  }
+  return shape(A_tiles, B_tiles);
+}
+
+std::ostream &operator<<(std::ostream &out,
+                         const stream_statistics &statistics) {
+  out << statistics.tiles << " tiles, read "
+      << (statistics.bytes_read / (1024.0 * 1024.0 * 1024.0))
+      << " GB in " << statistics.read_duration << "s, waited "
+      << statistics.io_wait_duration << "s for reads, packing "
+      << statistics.packing_duration
+      << "s, compute " << statistics.compute_duration << "s";
+  return out;
+}
+
+void gemm(size_t M, size_t N, size_t K, const double *A, const double *B,
+          bool transposed, double *C, const panel_shape &panels,
+          const memory_layout::blocking_configuration &blocking,
+          const rows_done_callback &rows_done, stream_statistics &statistics) {
+  if (M == 0 || N == 0 || K == 0) {
+    throw util::matrix_multiplication_exception(
+        "out-of-core product with an empty dimension");
+  }
+  if (panels.rows == 0 || panels.cols == 0) {
+    throw util::matrix_multiplication_exception("panels have to be non-empty");
+  }
+  size_t row_panels = (M + panels.rows - 1) / panels.rows;
+  size_t col_panels = (N + panels.cols - 1) / panels.cols;
+  size_t tiles = row_panels * col_panels;
+  auto panel_rows = [&](size_t row_panel) {
+    return std::min(panels.rows, M - row_panel * panels.rows);
+  };
+  auto panel_cols = [&](size_t col_panel) {
+    return std::min(panels.cols, N - col_panel * panels.cols);
+  };
+
+  // the loader reads into the buffers the current tile doesn't use
+  std::vector<double> A_buffers[2];
+  std::vector<double> B_buffers[2];
+  for (size_t slot = 0; slot < 2; slot++) {
+    A_buffers[slot].resize(std::min(panels.rows, M) * K);
+    B_buffers[slot].resize(std::min(panels.cols, N) * K);
+  }
+  size_t A_slot = 0;
+  size_t B_slot = 0;
+  std::chrono::high_resolution_clock::time_point first_read =
+      std::chrono::high_resolution_clock::now();
+  read_A_panel(A, K, 0, panel_rows(0), A_buffers[0].data());
+  read_B_panel(B, N, K, transposed, 0, panel_cols(0), B_buffers[0].data());
+  statistics.read_duration += seconds_since(first_read);
+  statistics.io_wait_duration += seconds_since(first_read);
+  statistics.bytes_read +=
+      static_cast<double>((panel_rows(0) + panel_cols(0)) * K) *
+      sizeof(double);
+
+  std::unique_ptr<kernel_tiled::packed_operand<double>> A_packed;
+  std::unique_ptr<kernel_tiled::packed_operand<double>> B_packed;
+  // returns the time the reads took, declared after the buffers, so that it
+  // is waited for before they go away
+  std::future<double> pending_read;
+
+  tile_position previous = {row_panels, col_panels};
+  for (size_t tile = 0; tile < tiles; tile++) {
+    tile_position current = get_tile(tile, col_panels);
+    bool new_A = current.row_panel != previous.row_panel;
+    bool new_B = current.col_panel != previous.col_panel;
+    if (pending_read.valid()) {
+      std::chrono::high_resolution_clock::time_point start =
+          std::chrono::high_resolution_clock::now();
+      statistics.read_duration += pending_read.get();
+      statistics.io_wait_duration += seconds_since(start);
+      A_slot = new_A ? 1 - A_slot : A_slot;
+      B_slot = new_B ? 1 - B_slot : B_slot;
+    }
+
+    if (tile + 1 < tiles) {
+      tile_position next = get_tile(tile + 1, col_panels);
+      bool read_A = next.row_panel != current.row_panel;
+      bool read_B = next.col_panel != current.col_panel;
+      size_t A_rows = read_A ? panel_rows(next.row_panel) : 0;
+      size_t B_cols = read_B ? panel_cols(next.col_panel) : 0;
+      double *A_buffer = A_buffers[1 - A_slot].data();
+      double *B_buffer = B_buffers[1 - B_slot].data();
+      pending_read = std::async(std::launch::async, [=]() {
+        std::chrono::high_resolution_clock::time_point start =
+            std::chrono::high_resolution_clock::now();
+        if (A_rows > 0) {
+          read_A_panel(A, K, next.row_panel * panels.rows, A_rows, A_buffer);
+        }
+        if (B_cols > 0) {
+          read_B_panel(B, N, K, transposed, next.col_panel * panels.cols,
+                       B_cols, B_buffer);
+        }
+        return seconds_since(start);
+      });
+      statistics.bytes_read +=
+          static_cast<double>((A_rows + B_cols) * K) * sizeof(double);
+    }
+
+    size_t rows = panel_rows(current.row_panel);
+    size_t cols = panel_cols(current.col_panel);
+    std::chrono::high_resolution_clock::time_point packing_start =
+        std::chrono::high_resolution_clock::now();
+    if (new_A) {
+      A_packed.reset(new kernel_tiled::packed_operand<double>(
+          kernel_tiled::pack_A(A_buffers[A_slot].data(), rows, K, K, false,
+                               blocking)));
+    }
+    if (new_B) {
+      B_packed.reset(new kernel_tiled::packed_operand<double>(
+          kernel_tiled::pack_B(B_buffers[B_slot].data(), K, cols,
+                               transposed ? K : cols, transposed, blocking)));
+    }
+    statistics.packing_duration += seconds_since(packing_start);
+
+    kernel_tiled::kernel_tiled<double> m(*A_packed, *B_packed, 1, 0);
+    m.matrix_multiply(1.0, 0.0,
+                      C + current.row_panel * panels.rows * N +
+                          current.col_panel * panels.cols,
+                      N, statistics.compute_duration);
+    statistics.tiles += 1;
+
+    if ((tile + 1) % col_panels == 0) {
+      size_t row_begin = current.row_panel * panels.rows;
+      rows_done(row_begin, row_begin + rows);
+    }
+    previous = current;
+  }
+}
+
+out_of_core::out_of_core(const util::mapped_matrix &A,
+                         const util::mapped_matrix &B, bool transposed,
+                         util::mapped_matrix &C, uint64_t repetitions,
+                         uint64_t verbose, size_t memory_budget,
+                         const memory_layout::blocking_configuration &blocking)
+    : A(A), B(B), transposed(transposed), C(C), repetitions(repetitions),
+      verbose(verbose), blocking(blocking) {
+  size_t K = A.get_cols();
+  size_t B_rows = transposed ? B.get_cols() : B.get_rows();
+  size_t B_cols = transposed ? B.get_rows() : B.get_cols();
+  if (B_rows != K) {
+    throw util::matrix_multiplication_exception(
+        "out_of_core: the columns of A and the rows of B differ");
+  }
+  if (C.get_rows() != A.get_rows() || C.get_cols() != B_cols) {
+    throw util::matrix_multiplication_exception(
+        "out_of_core: C doesn't have the size of the product");
+  }
+  panels = choose_panels(A.get_rows(), B_cols, K, memory_budget,
+                         omp_get_max_threads(), blocking);
+  if (verbose >= 1) {
+    std::cout << "out-of-core panels: " << panels << ", buffers: "
+              << (buffer_bytes(panels, K, blocking) / (1024.0 * 1024.0))
+              << " MB" << std::endl;
+  }
+}
+
+void out_of_core::matrix_multiply(double &duration) {
+  size_t M = C.get_rows();
+  size_t N = C.get_cols();
+  size_t K = A.get_cols();
+
+  double duration_sum = 0.0;
+  repetition_durations.clear();
+  statistics = stream_statistics();
+  for (size_t rep = 0; rep < repetitions; rep++) {
+    util::perf_phase phase("out_of_core compute");
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    // one row panel of C is written back while the next one is computed
+    std::future<void> pending_write;
+    gemm(M, N, K, A.data(), B.data(), transposed, C.data(), panels, blocking,
+         [this, &pending_write](size_t row_begin, size_t row_end) {
+           if (pending_write.valid()) {
+             pending_write.get();
+           }
+           pending_write =
+               std::async(std::launch::async, [this, row_begin, row_end]() {
+                 C.write_back(row_begin, row_end);
+               });
+         },
+         statistics);
+    pending_write.get();
+    repetition_durations.push_back(seconds_since(start));
+    duration_sum += repetition_durations.back();
+  }
+  duration += duration_sum;
+
+  std::cout << "duration inner: " << duration << "s" << std::endl;
+
+  double flops = 2 * static_cast<double>(M) * static_cast<double>(N) *
+                 static_cast<double>(K);
+  double gflop = flops / 1E9;
+  std::cout << "[M = " << M << ", N = " << N << ", K = " << K
+            << "] inner performance: " << (repetitions * gflop / duration_sum)
+            << "Gflops (average across repetitions)" << std::endl;
+
+  roofline::record_bandwidth("out_of_core reading panels",
+                             statistics.bytes_read, statistics.read_duration);
+
+  if (verbose >= 1) {
+    std::cout << "out-of-core streaming: " << statistics << std::endl;
+  }
+}
+}
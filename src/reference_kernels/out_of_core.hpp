@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "util/matrix_file.hpp"
+
+namespace out_of_core {
+
+// Product of matrices that don't fit into memory. C is computed tile by tile,
+// a tile is the product of a row panel of A (a multiple of L3_X rows and all
+// of K) and a column panel of B (all of K and a multiple of L3_Y columns),
+// computed by kernel_tiled from packed copies of the panels. While a tile is
+// computed, a loader thread reads the panels of the next tile into the second
+// of two buffers, so that the reads from disk overlap with the computation.
+// The column panels are visited back and forth, the last B panel of a row of
+// tiles is reused by the next one. Only the panels are resident, A is read
+// once, B once per row panel.
+
+// rows of the A panels and columns of the B panels
+struct panel_shape {
+  size_t rows;
+  size_t cols;
+};
+
+std::ostream &operator<<(std::ostream &out, const panel_shape &panels);
+
+// bytes taken by the buffers of the panels: two read buffers and the packed
+// copy for each of A and B, packed like kernel_tiled::pack_A and pack_B do
+// (k isn't padded, the rows and columns are padded to the register blocking)
+size_t buffer_bytes(const panel_shape &panels, size_t K,
+                    const memory_layout::blocking_configuration &blocking);
+
+// largest panels that fit into memory_budget bytes, the B panels only get as
+// many L3 tiles as needed for a tile of C to have at least one L3 tile per
+// thread (or as many as the budget allows), the rest goes to the A panels,
+// which decide how often B is read; at least one L3 tile each, even if that
+// exceeds the budget
+panel_shape
+choose_panels(size_t M, size_t N, size_t K, size_t memory_budget,
+              size_t threads,
+              const memory_layout::blocking_configuration &blocking);
+
+// what gemm() spent its time on
+struct stream_statistics {
+  size_t tiles = 0;
+  double bytes_read = 0.0;
+  // time the loader thread spent reading
+  double read_duration = 0.0;
+  // time the computation waited for the loader thread, includes the first
+  // panels, which can't overlap with anything
+  double io_wait_duration = 0.0;
+  double packing_duration = 0.0;
+  double compute_duration = 0.0;
+};
+
+std::ostream &operator<<(std::ostream &out,
+                         const stream_statistics &statistics);
+
+// called once the rows [row_begin, row_end) of C are final
+using rows_done_callback = std::function<void(size_t row_begin,
+                                              size_t row_end)>;
+
+// C = A * op(B) for row-major matrices without padding, A is M x K, B is
+// K x N or stored N x K if transposed, C is M x N, the operands can be
+// memory-mapped files; the statistics are added to, throws
+// util::matrix_multiplication_exception if a dimension is 0
+void gemm(size_t M, size_t N, size_t K, const double *A, const double *B,
+          bool transposed, double *C, const panel_shape &panels,
+          const memory_layout::blocking_configuration &blocking,
+          const rows_done_callback &rows_done, stream_statistics &statistics);
+
+class out_of_core {
+private:
+  const util::mapped_matrix &A;
+  const util::mapped_matrix &B;
+  bool transposed;
+  util::mapped_matrix &C;
+  uint64_t repetitions;
+  uint64_t verbose;
+  memory_layout::blocking_configuration blocking;
+  panel_shape panels;
+
+  // of the last matrix_multiply()
+  std::vector<double> repetition_durations;
+  stream_statistics statistics;
+
+public:
+  // A should be mapped with util::access_pattern::streamed, B is stored
+  // transposed if transposed, C has to be created with the size of the
+  // product; throws util::matrix_multiplication_exception if the dimensions
+  // don't match
+  out_of_core(const util::mapped_matrix &A, const util::mapped_matrix &B,
+              bool transposed, util::mapped_matrix &C, uint64_t repetitions,
+              uint64_t verbose, size_t memory_budget,
+              const memory_layout::blocking_configuration &blocking =
+                  memory_layout::blocking_configuration());
+
+  // computes C, repeated repetitions times, the rows of C are written back
+  // to the file in the background as soon as they are final
+  void matrix_multiply(double &duration);
+
+  const panel_shape &get_panels() const { return panels; }
+
+  // inner time of every repetition of the last matrix_multiply()
+  const std::vector<double> &get_repetition_durations() const {
+    return repetition_durations;
+  }
+
+  // summed over the repetitions of the last matrix_multiply()
+  const stream_statistics &get_statistics() const { return statistics; }
+};
+}
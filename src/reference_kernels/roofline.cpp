@@ -0,0 +1,167 @@
+#include "roofline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <omp.h>
+
+#include "memory_layout/page_allocator.hpp"
+#include "micro_kernel.hpp"
+
+namespace roofline {
+
+namespace {
+
+std::atomic<bool> reporting_enabled(false);
+
+struct record {
+  std::string name;
+  // Gflops or GB/s
+  double rate;
+  enum class kind { bandwidth, compute_double, compute_float } type;
+};
+
+std::mutex &records_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+std::vector<record> &records() {
+  static std::vector<record> r;
+  return r;
+}
+
+// best of a few runs, the first one also warms up the cores
+const size_t calibration_runs = 3;
+
+template <typename T> double measure_gflops() {
+  // about 10^8 multiply-adds per thread and run
+  const size_t iterations = 1 << 23;
+  double best = 0.0;
+  for (size_t run = 0; run < calibration_runs; run++) {
+    double flops = 0.0;
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+#pragma omp parallel reduction(+ : flops)
+    flops += micro_kernel::fma_loop<T>(iterations);
+    std::chrono::high_resolution_clock::time_point end =
+        std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    best = std::max(best, flops / seconds / 1E9);
+  }
+  return best;
+}
+
+double measure_bandwidth() {
+  // 3 x 64 MB, far larger than the last level caches
+  const size_t n = 1 << 23;
+  memory_layout::page_vector<double> a(n);
+  memory_layout::page_vector<double> b(n);
+  memory_layout::page_vector<double> c(n);
+  // first touch with the same static schedule as the triad
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; i++) {
+    a[i] = 0.0;
+    b[i] = 1.0;
+    c[i] = 2.0;
+  }
+  const double s = 3.0;
+  double best = 0.0;
+  for (size_t run = 0; run < calibration_runs + 2; run++) {
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++) {
+      a[i] = b[i] + s * c[i];
+    }
+    std::chrono::high_resolution_clock::time_point end =
+        std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    best = std::max(best, 3.0 * sizeof(double) * n / seconds / 1E9);
+  }
+  return best;
+}
+
+double percent(double value, double peak) {
+  return peak > 0.0 ? 100.0 * value / peak : 0.0;
+}
+}
+
+std::ostream &operator<<(std::ostream &out, const machine_peak &peak) {
+  out << "threads: " << peak.threads << ", " << peak.gflops_double
+      << " Gflops (double), " << peak.gflops_float << " Gflops (float), "
+      << peak.bandwidth << " GB/s (triad)";
+  return out;
+}
+
+machine_peak calibrate() {
+  machine_peak peak;
+  peak.threads = omp_get_max_threads();
+  peak.gflops_double = measure_gflops<double>();
+  peak.gflops_float = measure_gflops<float>();
+  peak.bandwidth = measure_bandwidth();
+  return peak;
+}
+
+const machine_peak &get_machine_peak() {
+  static machine_peak peak = calibrate();
+  return peak;
+}
+
+void set_reporting(bool enabled) { reporting_enabled = enabled; }
+
+bool get_reporting() { return reporting_enabled; }
+
+void record_bandwidth(const std::string &phase, double bytes, double seconds) {
+  if (!reporting_enabled || seconds <= 0.0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(records_mutex());
+  records().push_back({phase, bytes / seconds / 1E9, record::kind::bandwidth});
+}
+
+void record_compute(const std::string &run, double gflops,
+                    bool single_precision) {
+  if (!reporting_enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(records_mutex());
+  records().push_back({run, gflops, single_precision
+                                        ? record::kind::compute_float
+                                        : record::kind::compute_double});
+}
+
+void print_report(std::ostream &out) {
+  std::vector<record> current;
+  {
+    std::lock_guard<std::mutex> lock(records_mutex());
+    current.swap(records());
+  }
+  if (current.empty()) {
+    return;
+  }
+  const machine_peak &peak = get_machine_peak();
+  out << "machine peak: " << peak << std::endl;
+  for (const record &r : current) {
+    switch (r.type) {
+    case record::kind::bandwidth:
+      out << r.name << ": " << r.rate << " GB/s, "
+          << percent(r.rate, peak.bandwidth) << "% of bandwidth peak"
+          << std::endl;
+      break;
+    case record::kind::compute_float:
+      out << r.name << ": " << r.rate << " Gflops, "
+          << percent(r.rate, peak.gflops_float) << "% of compute peak (float)"
+          << std::endl;
+      break;
+    default:
+      out << r.name << ": " << r.rate << " Gflops, "
+          << percent(r.rate, peak.gflops_double) << "% of compute peak"
+          << std::endl;
+    }
+  }
+}
+}
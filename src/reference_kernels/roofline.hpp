@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace roofline {
+
+// sustained throughput of the machine, measured with all OpenMP threads on
+// the cores the process may use
+struct machine_peak {
+  size_t threads;
+  // register-only multiply-add loop with the vectors of the active
+  // instruction set
+  double gflops_double;
+  double gflops_float;
+  // STREAM triad (a = b + s * c), 24 bytes per element, without the write
+  // allocate traffic
+  double bandwidth;
+};
+
+std::ostream &operator<<(std::ostream &out, const machine_peak &peak);
+
+// runs both measurements, takes about a second
+machine_peak calibrate();
+
+// calibrates on first use, the result is kept for the process
+const machine_peak &get_machine_peak();
+
+// whether the engines record their phases for print_report(), off by default
+void set_reporting(bool enabled);
+
+bool get_reporting();
+
+// a packing phase that read and wrote bytes in seconds
+void record_bandwidth(const std::string &phase, double bytes, double seconds);
+
+// the rate of a multiply, measured with the classical flop count
+void record_compute(const std::string &run, double gflops,
+                    bool single_precision);
+
+// Prints the recorded phases as fractions of the peaks and clears them.
+// Calibrates if necessary, so it has to be called while no other work is
+// running, e.g. not while the HPX runtime is active.
+void print_report(std::ostream &out = std::cout);
+}
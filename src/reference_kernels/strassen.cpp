@@ -0,0 +1,274 @@
+#include "strassen.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "kernel_tiled.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+#include "util/perf_counters.hpp"
+
+namespace strassen {
+
+namespace {
+
+// element (i, j) of op(M) for a row-major M with leading dimension ld
+template <typename T> struct operand_view {
+  const T *data;
+  size_t ld;
+  bool transposed;
+
+  T operator()(size_t i, size_t j) const {
+    return transposed ? data[j * ld + i] : data[i * ld + j];
+  }
+
+  // view of op(M) starting at row i and column j
+  operand_view block(size_t i, size_t j) const {
+    return transposed ? operand_view{data + j * ld + i, ld, true}
+                      : operand_view{data + i * ld + j, ld, false};
+  }
+};
+
+bool is_leaf(size_t M, size_t N, size_t K, size_t cutoff) {
+  size_t smallest = std::min(M, std::min(N, K));
+  return smallest <= cutoff || smallest < 2;
+}
+
+// out = X + sign * Y, out may be X or Y
+template <typename T>
+void combine(size_t rows, size_t cols, operand_view<T> X, operand_view<T> Y,
+             T sign, T *out, size_t ld_out) {
+#pragma omp parallel for
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      out[i * ld_out + j] = X(i, j) + sign * Y(i, j);
+    }
+  }
+}
+
+template <typename T>
+void leaf(operand_view<T> A, operand_view<T> B, size_t M, size_t N, size_t K,
+          T beta, T *C, size_t ldc,
+          const memory_layout::blocking_configuration &blocking) {
+  kernel_tiled::gemm(A.transposed, B.transposed, M, N, K, T(1), A.data, A.ld,
+                     B.data, B.ld, beta, C, ldc, blocking);
+}
+
+template <typename T>
+void multiply(operand_view<T> A, operand_view<T> B, size_t M, size_t N,
+              size_t K, T *C, size_t ldc, size_t cutoff, T *workspace,
+              const memory_layout::blocking_configuration &blocking) {
+  if (is_leaf(M, N, K, cutoff)) {
+    leaf(A, B, M, N, K, T(0), C, ldc, blocking);
+    return;
+  }
+
+  const size_t mh = M / 2;
+  const size_t nh = N / 2;
+  const size_t kh = K / 2;
+
+  // the temporaries of this level, the levels below use the rest
+  T *S = workspace;
+  T *U = S + mh * kh;
+  T *P = U + kh * nh;
+  T *next = P + mh * nh;
+  const operand_view<T> S_view{S, kh, false};
+  const operand_view<T> U_view{U, nh, false};
+  const operand_view<T> P_view{P, nh, false};
+
+  const operand_view<T> A11 = A.block(0, 0);
+  const operand_view<T> A12 = A.block(0, kh);
+  const operand_view<T> A21 = A.block(mh, 0);
+  const operand_view<T> A22 = A.block(mh, kh);
+  const operand_view<T> B11 = B.block(0, 0);
+  const operand_view<T> B12 = B.block(0, nh);
+  const operand_view<T> B21 = B.block(kh, 0);
+  const operand_view<T> B22 = B.block(kh, nh);
+  T *C11 = C;
+  T *C12 = C + nh;
+  T *C21 = C + mh * ldc;
+  T *C22 = C + mh * ldc + nh;
+  const operand_view<T> C11_view{C11, ldc, false};
+  const operand_view<T> C12_view{C12, ldc, false};
+  const operand_view<T> C21_view{C21, ldc, false};
+  const operand_view<T> C22_view{C22, ldc, false};
+
+  // Winograd's schedule, the quadrants of C hold intermediate sums, so that
+  // only the three temporaries S, U and P are needed
+  // P7 = (A11 - A21) (B22 - B12)
+  combine(mh, kh, A11, A21, T(-1), S, kh);
+  combine(kh, nh, B22, B12, T(-1), U, nh);
+  multiply(S_view, U_view, mh, nh, kh, C21, ldc, cutoff, next, blocking);
+  // P5 = (A21 + A22) (B12 - B11)
+  combine(mh, kh, A21, A22, T(1), S, kh);
+  combine(kh, nh, B12, B11, T(-1), U, nh);
+  multiply(S_view, U_view, mh, nh, kh, C22, ldc, cutoff, next, blocking);
+  // P6 = (A21 + A22 - A11) (B22 - B12 + B11)
+  combine(mh, kh, S_view, A11, T(-1), S, kh);
+  combine(kh, nh, B22, U_view, T(-1), U, nh);
+  multiply(S_view, U_view, mh, nh, kh, C12, ldc, cutoff, next, blocking);
+  // P1 = A11 B11
+  multiply(A11, B11, mh, nh, kh, P, nh, cutoff, next, blocking);
+  // C12 = P1 + P6, C21 = P1 + P6 + P7
+  combine(mh, nh, C12_view, P_view, T(1), C12, ldc);
+  combine(mh, nh, C21_view, C12_view, T(1), C21, ldc);
+  // C12 = P1 + P6 + P5, C22 = P1 + P6 + P7 + P5 (final)
+  combine(mh, nh, C12_view, C22_view, T(1), C12, ldc);
+  combine(mh, nh, C22_view, C21_view, T(1), C22, ldc);
+  // P3 = (A12 - A21 - A22 + A11) B22, C12 += P3 (final)
+  combine(mh, kh, A12, S_view, T(-1), S, kh);
+  multiply(S_view, B22, mh, nh, kh, C11, ldc, cutoff, next, blocking);
+  combine(mh, nh, C12_view, C11_view, T(1), C12, ldc);
+  // P4 = A22 (B22 - B12 + B11 - B21), C21 -= P4 (final)
+  combine(kh, nh, U_view, B21, T(-1), U, nh);
+  multiply(A22, U_view, mh, nh, kh, C11, ldc, cutoff, next, blocking);
+  combine(mh, nh, C21_view, C11_view, T(-1), C21, ldc);
+  // P2 = A12 B21, C11 = P1 + P2 (final)
+  multiply(A12, B21, mh, nh, kh, C11, ldc, cutoff, next, blocking);
+  combine(mh, nh, C11_view, P_view, T(1), C11, ldc);
+
+  // dynamic peeling of odd dimensions
+  const size_t M_even = 2 * mh;
+  const size_t N_even = 2 * nh;
+  const size_t K_even = 2 * kh;
+  if (K_even < K) {
+    // rank-1 update with the last column of op(A) and row of op(B)
+    leaf(A.block(0, K_even), B.block(K_even, 0), M_even, N_even, 1, T(1), C,
+         ldc, blocking);
+  }
+  if (N_even < N) {
+    leaf(A, B.block(0, N_even), M, 1, K, T(0), C + N_even, ldc, blocking);
+  }
+  if (M_even < M) {
+    leaf(A.block(M_even, 0), B, 1, N_even, K, T(0), C + M_even * ldc, ldc,
+         blocking);
+  }
+}
+}
+
+size_t levels(size_t M, size_t N, size_t K, size_t cutoff) {
+  if (is_leaf(M, N, K, cutoff)) {
+    return 0;
+  }
+  return 1 + levels(M / 2, N / 2, K / 2, cutoff);
+}
+
+size_t workspace_size(size_t M, size_t N, size_t K, size_t cutoff) {
+  if (is_leaf(M, N, K, cutoff)) {
+    return 0;
+  }
+  const size_t mh = M / 2;
+  const size_t nh = N / 2;
+  const size_t kh = K / 2;
+  return mh * kh + kh * nh + mh * nh + workspace_size(mh, nh, kh, cutoff);
+}
+
+template <typename T>
+void gemm(bool transposed_A, bool transposed_B, size_t M, size_t N, size_t K,
+          const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc,
+          size_t cutoff, T *workspace,
+          const memory_layout::blocking_configuration &blocking) {
+  multiply(operand_view<T>{A, lda, transposed_A},
+           operand_view<T>{B, ldb, transposed_B}, M, N, K, C, ldc, cutoff,
+           workspace, blocking);
+}
+
+std::ostream &operator<<(std::ostream &out, const error_report &report) {
+  out << "levels: " << report.levels
+      << ", max |C_strassen - C_classical|: " << report.max_abs_difference
+      << ", normwise (units of K * max|A| * max|B|): "
+      << report.normwise_difference;
+  return out;
+}
+
+template <typename T>
+strassen<T>::strassen(size_t N, std::vector<T> &A_org, std::vector<T> &B_org,
+                      bool transposed, uint64_t repetitions, uint64_t verbose,
+                      size_t cutoff,
+                      const memory_layout::blocking_configuration &blocking)
+    : N(N), A_org(A_org), B_org(B_org), transposed(transposed),
+      repetitions(repetitions), verbose(verbose), cutoff(cutoff),
+      blocking(blocking), workspace(workspace_size(N, N, N, cutoff)) {
+  if (cutoff == 0) {
+    throw util::matrix_multiplication_exception(
+        "the Strassen cutoff has to be at least 1");
+  }
+  if (verbose >= 1) {
+    std::cout << "Strassen levels: " << levels(N, N, N, cutoff)
+              << ", workspace: "
+              << (workspace.size() * sizeof(T) / (1024.0 * 1024.0)) << " MB"
+              << std::endl;
+  }
+}
+
+template <typename T>
+std::vector<T> strassen<T>::matrix_multiply(double &duration) {
+
+  std::vector<T> C_return(N * N);
+
+  double duration_sum = 0.0;
+  repetition_durations.clear();
+  for (size_t rep = 0; rep < repetitions; rep++) {
+    // includes the packing of the leaves
+    util::perf_phase phase("strassen compute");
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    gemm(false, transposed, N, N, N, A_org.data(), N, B_org.data(), N,
+         C_return.data(), N, cutoff, workspace.data(), blocking);
+    std::chrono::high_resolution_clock::time_point end =
+        std::chrono::high_resolution_clock::now();
+    repetition_durations.push_back(
+        std::chrono::duration<double>(end - start).count());
+    duration_sum += repetition_durations.back();
+  }
+  duration += duration_sum;
+
+  std::cout << "duration inner: " << duration << "s" << std::endl;
+
+  // the classical flop count, so that the rate compares with kernel_tiled
+  double flops = 2 * static_cast<double>(N) * static_cast<double>(N) *
+                 static_cast<double>(N);
+  double gflop = flops / 1E9;
+  std::cout << "[N = " << N << ", cutoff = " << cutoff
+            << "] inner performance: " << (repetitions * gflop / duration_sum)
+            << "Gflops (effective, average across repetitions)" << std::endl;
+
+  if (verbose >= 1) {
+    std::cout << "Strassen error growth: " << compare_with_classical(C_return)
+              << std::endl;
+  }
+
+  return C_return;
+}
+
+template <typename T>
+error_report strassen<T>::compare_with_classical(const std::vector<T> &C) {
+  std::vector<T> C_classical(N * N);
+  kernel_tiled::gemm(false, transposed, N, N, N, T(1), A_org.data(), N,
+                     B_org.data(), N, T(0), C_classical.data(), N, blocking);
+
+  double max_difference = 0.0;
+  double max_A = 0.0;
+  double max_B = 0.0;
+  for (size_t i = 0; i < N * N; i++) {
+    max_difference = std::max(
+        max_difference, std::abs(static_cast<double>(C[i] - C_classical[i])));
+    max_A = std::max(max_A, std::abs(static_cast<double>(A_org[i])));
+    max_B = std::max(max_B, std::abs(static_cast<double>(B_org[i])));
+  }
+  double scale = static_cast<double>(N) * max_A * max_B;
+  return {levels(N, N, N, cutoff), max_difference,
+          scale == 0.0 ? 0.0 : max_difference / scale};
+}
+
+#define INSTANTIATE_STRASSEN(T)                                                \
+  template class strassen<T>;                                                  \
+  template void gemm<T>(bool, bool, size_t, size_t, size_t, const T *,         \
+                        size_t, const T *, size_t, T *, size_t, size_t, T *,   \
+                        const memory_layout::blocking_configuration &);
+
+INSTANTIATE_STRASSEN(double)
+INSTANTIATE_STRASSEN(float)
+
+#undef INSTANTIATE_STRASSEN
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/page_allocator.hpp"
+
+namespace strassen {
+
+// Strassen-Winograd recursion (7 products and 15 additions per level) on top
+// of kernel_tiled. Every level halves M, N and K, a product becomes a leaf
+// that is computed by kernel_tiled::gemm (packed, micro kernel path) once the
+// smallest of its dimensions is at most the cutoff. Odd dimensions are peeled
+// off and computed by kernel_tiled::gemm as thin products.
+
+// number of recursion levels for an M x K times K x N product
+size_t levels(size_t M, size_t N, size_t K, size_t cutoff);
+
+// elements of workspace needed by gemm(), three temporaries per level
+size_t workspace_size(size_t M, size_t N, size_t K, size_t cutoff);
+
+// C = op(A) * op(B) for row-major matrices with leading dimensions, op(A) is
+// M x K, op(B) is K x N, workspace has to hold workspace_size() elements
+template <typename T>
+void gemm(bool transposed_A, bool transposed_B, size_t M, size_t N, size_t K,
+          const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc,
+          size_t cutoff, T *workspace,
+          const memory_layout::blocking_configuration &blocking =
+              memory_layout::blocking_configuration());
+
+// difference of a Strassen product to the classical (kernel_tiled) product of
+// the same operands
+struct error_report {
+  size_t levels;
+  // max |C_strassen - C_classical|
+  double max_abs_difference;
+  // max_abs_difference / (K * max |A| * max |B|), the normwise error bound
+  // of the classical algorithm is about K * eps in these units
+  double normwise_difference;
+};
+
+std::ostream &operator<<(std::ostream &out, const error_report &report);
+
+template <typename T> class strassen {
+private:
+  size_t N;
+  std::vector<T> &A_org;
+  std::vector<T> &B_org;
+  bool transposed;
+  uint64_t repetitions;
+  uint64_t verbose;
+  size_t cutoff;
+  memory_layout::blocking_configuration blocking;
+
+  // temporaries of all levels, allocated once and reused by the repetitions
+  memory_layout::page_vector<T> workspace;
+
+  // of the last matrix_multiply()
+  std::vector<double> repetition_durations;
+
+public:
+  // B_org is stored transposed if transposed, throws
+  // util::matrix_multiplication_exception if cutoff is 0
+  strassen(size_t N, std::vector<T> &A_org, std::vector<T> &B_org,
+           bool transposed, uint64_t repetitions, uint64_t verbose,
+           size_t cutoff,
+           const memory_layout::blocking_configuration &blocking =
+               memory_layout::blocking_configuration());
+
+  // returns the product (row-major, N x N), repeated repetitions times, with
+  // verbose >= 1 the error growth is reported
+  std::vector<T> matrix_multiply(double &duration);
+
+  // inner time of every repetition of the last matrix_multiply()
+  const std::vector<double> &get_repetition_durations() const {
+    return repetition_durations;
+  }
+
+  // computes the classical product and compares it with C
+  error_report compare_with_classical(const std::vector<T> &C);
+};
+}
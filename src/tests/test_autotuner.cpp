@@ -0,0 +1,83 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <cstdio>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "reference_kernels/autotuner.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_autotuner)
+
+BOOST_AUTO_TEST_CASE(size_class) {
+  BOOST_CHECK_EQUAL(autotuner::get_size_class(1), 64);
+  BOOST_CHECK_EQUAL(autotuner::get_size_class(1024), 1024);
+  BOOST_CHECK_EQUAL(autotuner::get_size_class(1025), 2048);
+}
+
+BOOST_AUTO_TEST_CASE(tuning_cache_roundtrip) {
+  std::string file_name = "test_autotuner_cache.txt";
+  std::remove(file_name.c_str());
+
+  autotuner::tuning_cache cache(file_name);
+  autotuner::tuning_key key{"test cpu", "avx2", "kernel_tiled", 4, 1024};
+  autotuner::tuning_key other_key{"test cpu", "avx2", "kernel_tiled", 8,
+                                  1024};
+  // tuned with other micro kernels
+  autotuner::tuning_key other_isa{"test cpu", "sse2", "kernel_tiled", 4,
+                                  1024};
+
+  memory_layout::blocking_configuration blocking;
+  BOOST_CHECK(!cache.lookup(key, blocking));
+
+  memory_layout::blocking_configuration tuned;
+  tuned.L3_X = 210;
+  tuned.L2_X = 35;
+  tuned.L1_K_STEP = 32;
+  tuned.set_register_blocking("4x12");
+  tuned.L1_Y = 24;
+  tuned.L2_Y = 48;
+  tuned.L3_Y = 96;
+  cache.store(key, tuned, 100.0);
+  cache.store(other_key, memory_layout::blocking_configuration(), 50.0);
+  // replaces the first entry
+  tuned.L3_Y = 192;
+  cache.store(key, tuned, 110.0);
+
+  BOOST_CHECK(cache.lookup(key, blocking));
+  BOOST_CHECK_EQUAL(blocking.L3_X, 210);
+  BOOST_CHECK_EQUAL(blocking.L3_Y, 192);
+  BOOST_CHECK_EQUAL(blocking.X_REG, 4);
+  BOOST_CHECK_EQUAL(blocking.Y_REG, 12);
+  BOOST_CHECK_EQUAL(blocking.L2_X, 35);
+  BOOST_CHECK_EQUAL(blocking.L1_K_STEP, 32);
+
+  BOOST_CHECK(cache.lookup(other_key, blocking));
+  BOOST_CHECK_EQUAL(blocking.L3_X, 420);
+  BOOST_CHECK(!cache.lookup(other_isa, blocking));
+
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(finds_synthetic_optimum) {
+  // synthetic performance model with a single optimum
+  auto benchmark = [](const memory_layout::blocking_configuration &b) {
+    return 1000.0 - std::abs(static_cast<double>(b.L1_X) - 20.0) -
+           std::abs(static_cast<double>(b.L1_K_STEP) - 128.0) -
+           std::abs(static_cast<double>(b.L3_Y) - 96.0) -
+           (b.X_REG == 4 ? 0.0 : 10.0);
+  };
+  autotuner::autotuner tuner(benchmark, {{5, 8}, {4, 12}}, 0);
+  double gflops;
+  memory_layout::blocking_configuration best =
+      tuner.tune(memory_layout::blocking_configuration(), gflops);
+  BOOST_CHECK_EQUAL(best.L1_X, 20);
+  BOOST_CHECK_EQUAL(best.X_REG, 4);
+  BOOST_CHECK_EQUAL(best.L1_K_STEP, 128);
+  BOOST_CHECK_EQUAL(best.L3_Y, 96);
+  BOOST_CHECK_CLOSE(gflops, 1000.0, 1E-10);
+  best.verify();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
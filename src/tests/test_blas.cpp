@@ -0,0 +1,90 @@
+#define BOOST_TEST_DYN_LINK
+
+#include "matmul/blas.h"
+#include "reference_kernels/naive.hpp"
+#include "util/create_random_matrix.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_blas)
+
+BOOST_AUTO_TEST_CASE(cblas_row_and_column_major) {
+  // embedded in 80 x 80 storage to test the leading dimensions
+  int ld = 80;
+  int M = 71;
+  int N = 38;
+  int K = 55;
+  double alpha = 1.5;
+  double beta = 0.5;
+  std::vector<double> A = util::create_random_matrix<double>(ld);
+  std::vector<double> B = util::create_random_matrix<double>(ld);
+  std::vector<double> C_org = util::create_random_matrix<double>(ld);
+
+  for (CBLAS_TRANSPOSE trans_A : {CblasNoTrans, CblasTrans}) {
+    for (CBLAS_TRANSPOSE trans_B : {CblasNoTrans, CblasConjTrans}) {
+      bool transposed_A = trans_A != CblasNoTrans;
+      bool transposed_B = trans_B != CblasNoTrans;
+
+      std::vector<double> C_reference(C_org);
+      naive_gemm(transposed_A, transposed_B, M, N, K, alpha, A.data(), ld,
+                 B.data(), ld, beta, C_reference.data(), ld);
+      std::vector<double> C(C_org);
+      cblas_dgemm(CblasRowMajor, trans_A, trans_B, M, N, K, alpha, A.data(),
+                  ld, B.data(), ld, beta, C.data(), ld);
+      for (int i = 0; i < ld * ld; i++) {
+        BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-9);
+      }
+
+      // column-major: the row-major reference of the transposed product
+      // C^T = op(B)^T op(A)^T, a column-major matrix read row-major is its
+      // transpose, so the flags are unchanged
+      std::vector<double> C_col_reference(C_org);
+      naive_gemm(transposed_B, transposed_A, N, M, K, alpha, B.data(), ld,
+                 A.data(), ld, beta, C_col_reference.data(), ld);
+      std::vector<double> C_col(C_org);
+      cblas_dgemm(CblasColMajor, trans_A, trans_B, M, N, K, alpha, A.data(),
+                  ld, B.data(), ld, beta, C_col.data(), ld);
+      std::vector<double> C_fortran(C_org);
+      char transa = transposed_A ? 't' : 'N';
+      char transb = transposed_B ? 'C' : 'n';
+      dgemm_(&transa, &transb, &M, &N, &K, &alpha, A.data(), &ld, B.data(),
+             &ld, &beta, C_fortran.data(), &ld);
+      for (int i = 0; i < ld * ld; i++) {
+        BOOST_CHECK_CLOSE(C_col[i], C_col_reference[i], 1E-9);
+        BOOST_CHECK_EQUAL(C_fortran[i], C_col[i]);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(illegal_arguments) {
+  std::vector<double> A(16, 1.0);
+  std::vector<double> B(16, 1.0);
+  std::vector<double> C(16, 2.0);
+  // lda too small, C must not change
+  cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 4, 4, 4, 1.0,
+              A.data(), 3, B.data(), 4, 0.0, C.data(), 4);
+  char transa = 'X';
+  char transb = 'N';
+  int n = 4;
+  double alpha = 1.0;
+  double beta = 0.0;
+  dgemm_(&transa, &transb, &n, &n, &n, &alpha, A.data(), &n, B.data(), &n,
+         &beta, C.data(), &n);
+  for (double c : C) {
+    BOOST_CHECK_EQUAL(c, 2.0);
+  }
+
+  // tiny products take the naive path, beta = 1 and alpha = 0 is a no-op
+  cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 4, 4, 4, 0.0,
+              A.data(), 4, B.data(), 4, 1.0, C.data(), 4);
+  cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 4, 4, 4, 1.0,
+              A.data(), 4, B.data(), 4, 1.0, C.data(), 4);
+  for (double c : C) {
+    BOOST_CHECK_EQUAL(c, 6.0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
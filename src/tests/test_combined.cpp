@@ -481,4 +481,50 @@ BOOST_AUTO_TEST_CASE(random_matrices_1024) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(random_matrices_256_transposed) {
+
+  using namespace hpx_parameters;
+
+  N = 256;
+
+  A = util::create_random_matrix<double>(N);
+  B = util::create_random_matrix<double>(N);
+
+  C = std::vector<double>();
+  C_reference = std::vector<double>();
+
+  algorithm = "combined";
+  verbose = false;
+  check = true;
+  // is B transposed, relevant for some (reference) algorithm
+  transposed = true;
+
+  block_input = 128;
+  block_result = 128;
+
+  duration = 0.0; // write variable
+  repetitions = 1;
+  is_root_node = false;
+
+  min_work_size = 0;                  // unused
+  max_work_difference = 0;            // unused
+  max_relative_work_difference = 0.0; // unused
+
+  // Initialize HPX, run hpx_main.
+  start_hpx_with_threads(omp_get_max_threads());
+
+  // Wait for hpx::finalize being called.
+  hpx::stop();
+
+  if (!transposed) {
+    C_reference = naive_matrix_multiply(N, A, B);
+  } else {
+    C_reference = naive_matrix_multiply_transposed(N, A, B);
+  }
+
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_SMALL(fabs(C[i] - C_reference[i]), 1E-8);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
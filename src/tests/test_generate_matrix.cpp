@@ -0,0 +1,161 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "util/generate_matrix.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+#include <omp.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_generate_matrix)
+
+namespace {
+
+const util::matrix_pattern all_patterns[] = {
+    util::matrix_pattern::uniform, util::matrix_pattern::normal,
+    util::matrix_pattern::identity, util::matrix_pattern::diagonal,
+    util::matrix_pattern::enumerating};
+
+// serial, last block first
+void reverse_block_loop(size_t blocks,
+                        const std::function<void(size_t)> &body) {
+  for (size_t block = blocks; block > 0; block--) {
+    body(block - 1);
+  }
+}
+}
+
+BOOST_AUTO_TEST_CASE(bit_identical_for_any_thread_count) {
+  // not a multiple of the block size
+  size_t rows = 301;
+  size_t cols = 257;
+  int max_threads = omp_get_max_threads();
+  for (util::matrix_pattern pattern : all_patterns) {
+    for (bool transposed : {false, true}) {
+      util::generator_options options;
+      options.seed = 42;
+      options.transposed = transposed;
+      std::vector<double> reference = util::generate_matrix<double>(
+          pattern, rows, cols, options, reverse_block_loop);
+      for (int threads : {1, 3, 8}) {
+        omp_set_num_threads(threads);
+        std::vector<double> m =
+            util::generate_matrix<double>(pattern, rows, cols, options);
+        BOOST_CHECK(std::memcmp(m.data(), reference.data(),
+                                m.size() * sizeof(double)) == 0);
+      }
+      omp_set_num_threads(max_threads);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(transposed_is_the_transpose) {
+  size_t rows = 130;
+  size_t cols = 170;
+  for (util::matrix_pattern pattern : all_patterns) {
+    std::vector<float> m = util::generate_matrix<float>(pattern, rows, cols);
+    util::generator_options options;
+    options.transposed = true;
+    std::vector<float> m_t =
+        util::generate_matrix<float>(pattern, rows, cols, options);
+    bool equal = true;
+    for (size_t i = 0; i < rows; i++) {
+      for (size_t j = 0; j < cols; j++) {
+        equal = equal && m[i * cols + j] == m_t[j * rows + i];
+      }
+    }
+    BOOST_CHECK_MESSAGE(equal, util::to_string(pattern));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(patterns) {
+  size_t N = 150;
+  std::vector<double> identity =
+      util::generate_matrix<double>(util::matrix_pattern::identity, N, N);
+  std::vector<double> diagonal =
+      util::generate_matrix<double>(util::matrix_pattern::diagonal, N, N);
+  std::vector<double> enumerating =
+      util::generate_matrix<double>(util::matrix_pattern::enumerating, N, N);
+  std::vector<double> uniform =
+      util::generate_matrix<double>(util::matrix_pattern::uniform, N, N);
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      size_t index = i * N + j;
+      BOOST_CHECK_EQUAL(identity[index], i == j ? 1.0 : 0.0);
+      // the diagonal of the uniform matrix
+      BOOST_CHECK_EQUAL(diagonal[index], i == j ? uniform[index] : 0.0);
+      BOOST_CHECK_EQUAL(enumerating[index], static_cast<double>(index));
+    }
+  }
+
+  util::generator_options other_seed;
+  other_seed.seed = 1;
+  std::vector<double> other = util::generate_matrix<double>(
+      util::matrix_pattern::uniform, N, N, other_seed);
+  BOOST_CHECK(other != uniform);
+}
+
+BOOST_AUTO_TEST_CASE(distributions) {
+  size_t N = 400;
+  for (util::matrix_pattern pattern :
+       {util::matrix_pattern::uniform, util::matrix_pattern::normal}) {
+    std::vector<double> m = util::generate_matrix<double>(pattern, N, N);
+    double sum = 0.0;
+    double square_sum = 0.0;
+    double min = m[0];
+    double max = m[0];
+    for (double value : m) {
+      sum += value;
+      square_sum += value * value;
+      min = std::min(min, value);
+      max = std::max(max, value);
+    }
+    double mean = sum / m.size();
+    double variance = square_sum / m.size() - mean * mean;
+    if (pattern == util::matrix_pattern::uniform) {
+      BOOST_CHECK_GE(min, 0.0);
+      BOOST_CHECK_LT(max, 1.0);
+      BOOST_CHECK_SMALL(mean - 0.5, 0.01);
+      BOOST_CHECK_SMALL(variance - 1.0 / 12.0, 0.01);
+    } else {
+      BOOST_CHECK_SMALL(mean, 0.01);
+      BOOST_CHECK_SMALL(variance - 1.0, 0.01);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(float_below_one) {
+  // the float elements are the double elements truncated to 24 bits, never
+  // rounded up to 1
+  size_t N = 300;
+  std::vector<double> m_double =
+      util::generate_matrix<double>(util::matrix_pattern::uniform, N, N);
+  std::vector<float> m_float =
+      util::generate_matrix<float>(util::matrix_pattern::uniform, N, N);
+  bool truncated = true;
+  for (size_t i = 0; i < N * N; i++) {
+    double expected = std::ldexp(std::floor(std::ldexp(m_double[i], 24)), -24);
+    truncated = truncated && m_float[i] == expected && m_float[i] < 1.0f;
+  }
+  BOOST_CHECK(truncated);
+}
+
+BOOST_AUTO_TEST_CASE(names) {
+  for (util::matrix_pattern pattern : all_patterns) {
+    BOOST_CHECK(util::matrix_pattern_from_string(util::to_string(pattern)) ==
+                pattern);
+  }
+  BOOST_CHECK_THROW(util::matrix_pattern_from_string("random"),
+                    util::matrix_multiplication_exception);
+  BOOST_CHECK_EQUAL(util::generator_blocks(0, 10), 0);
+  BOOST_CHECK_EQUAL(util::generator_blocks(128, 128), 1);
+  BOOST_CHECK_EQUAL(util::generator_blocks(129, 128), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
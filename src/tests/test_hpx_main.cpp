@@ -72,11 +72,7 @@ int hpx_main(int argc, char *argv[]) {
     semi::semi m(N, A, B, block_result, block_input);
     C = m.matrix_multiply();
   } else if (hpx_parameters::algorithm.compare("combined") == 0) {
-    if (transposed) {
-      throw util::matrix_multiplication_exception(
-          "algorithm \"combined\" doens't allow B to be transposed");
-    }
-    combined::combined m(N, A, B, repetitions, verbose);
+    combined::combined m(N, A, B, transposed, repetitions, verbose);
     double inner_duration;
     C = m.matrix_multiply(inner_duration);
   } else if (hpx_parameters::algorithm.compare("proposal") == 0) {
@@ -0,0 +1,361 @@
+#define BOOST_TEST_DYN_LINK
+
+#include "util/create_identity_matrix.hpp"
+#include "util/create_random_matrix.hpp"
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/memory_layout_exception.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+#include "reference_kernels/kernel_tiled.hpp"
+#include "reference_kernels/micro_kernel.hpp"
+#include "reference_kernels/naive.hpp"
+
+#include <vector>
+
+#include <omp.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_kernel_tiled)
+
+BOOST_AUTO_TEST_CASE(random_matrices_256) {
+
+  size_t N = 256;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+
+  std::vector<double> C_reference = naive_matrix_multiply(N, A, B);
+
+  kernel_tiled::kernel_tiled<double> m(N, A, B, false, 1, 0);
+  double duration = 0.0;
+  std::vector<double> C = m.matrix_multiply(duration);
+
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(custom_blocking_100) {
+
+  size_t N = 100;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+
+  std::vector<double> C_reference = naive_matrix_multiply(N, A, B);
+
+  memory_layout::blocking_configuration blocking;
+  blocking.L3_X = 40;
+  blocking.L3_Y = 32;
+  blocking.L3_K_STEP = 32;
+  blocking.L2_X = 20;
+  blocking.L2_Y = 16;
+  blocking.L2_K_STEP = 16;
+  blocking.L1_X = 10;
+  blocking.L1_Y = 8;
+  blocking.L1_K_STEP = 8;
+
+  kernel_tiled::kernel_tiled<double> m(N, A, B, false, 1, 0, blocking);
+  double duration = 0.0;
+  std::vector<double> C = m.matrix_multiply(duration);
+
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(transposed_B_101) {
+
+  size_t N = 101;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+  std::vector<double> B_trans(N * N);
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      B_trans[j * N + i] = B[i * N + j];
+    }
+  }
+
+  std::vector<double> C_reference = naive_matrix_multiply(N, A, B);
+
+  // B is passed in its transposed storage order
+  kernel_tiled::kernel_tiled<double> m(N, A, B_trans, true, 1, 0);
+  double duration = 0.0;
+  std::vector<double> C = m.matrix_multiply(duration);
+
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(micro_kernels_all_isa_120) {
+
+  size_t N = 120;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+
+  std::vector<double> C_reference = naive_matrix_multiply(N, A, B);
+
+  for (const char *level : {"sse2", "avx", "avx2"}) {
+    try {
+      micro_kernel::set_isa(level);
+    } catch (memory_layout::memory_layout_exception &) {
+      continue; // not supported by this machine
+    }
+    for (auto shape : micro_kernel::available_shapes()) {
+      memory_layout::blocking_configuration blocking;
+      blocking.X_REG = shape.first;
+      blocking.Y_REG = shape.second;
+      blocking.L1_X = 2 * shape.first;
+      blocking.L1_Y = 2 * shape.second;
+      blocking.L1_K_STEP = 16;
+      blocking.L2_X = blocking.L1_X;
+      blocking.L2_Y = blocking.L1_Y;
+      blocking.L2_K_STEP = 32;
+      blocking.L3_X = 2 * blocking.L2_X;
+      blocking.L3_Y = 2 * blocking.L2_Y;
+      blocking.L3_K_STEP = 64;
+
+      kernel_tiled::kernel_tiled<double> m(N, A, B, false, 1, 0, blocking);
+      double duration = 0.0;
+      std::vector<double> C = m.matrix_multiply(duration);
+
+      for (size_t i = 0; i < N * N; i++) {
+        BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+      }
+    }
+  }
+  micro_kernel::set_isa("auto");
+}
+
+BOOST_AUTO_TEST_CASE(prepacked_B_reused) {
+
+  size_t N = 100;
+
+  std::vector<double> B = util::create_random_matrix<double>(N);
+  kernel_tiled::packed_operand<double> B_packed = kernel_tiled::pack_B(N, B);
+
+  for (size_t i = 0; i < 2; i++) {
+    std::vector<double> A = util::create_random_matrix<double>(N);
+    // make the second A differ from the first one
+    A[i] += 1.0;
+    std::vector<double> C_reference = naive_matrix_multiply(N, A, B);
+
+    kernel_tiled::kernel_tiled<double> m(kernel_tiled::pack_A(N, A), B_packed,
+                                         1, 0);
+    double duration = 0.0;
+    std::vector<double> C = m.matrix_multiply(duration);
+
+    for (size_t j = 0; j < N * N; j++) {
+      BOOST_CHECK_CLOSE(C[j], C_reference[j], 1E-10);
+    }
+  }
+
+  kernel_tiled::packed_operand<double> A_packed = kernel_tiled::pack_A(N, B);
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(B_packed, A_packed, 1, 0),
+      memory_layout::memory_layout_exception);
+  memory_layout::blocking_configuration other_blocking;
+  other_blocking.L1_K_STEP = 32;
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(
+          kernel_tiled::pack_A(N, B, other_blocking), B_packed, 1, 0),
+      memory_layout::memory_layout_exception);
+  std::vector<double> A_larger = util::create_random_matrix<double>(N + 1);
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(
+          kernel_tiled::pack_A(N + 1, A_larger), B_packed, 1, 0),
+      memory_layout::memory_layout_exception);
+}
+
+BOOST_AUTO_TEST_CASE(rectangular_gemm) {
+
+  // all matrices are embedded in 64 x 64 storage to test leading dimensions
+  size_t ld = 64;
+  size_t M = 37;
+  size_t N = 53;
+  size_t K = 45;
+
+  std::vector<double> A = util::create_random_matrix<double>(ld);
+  std::vector<double> B = util::create_random_matrix<double>(ld);
+  std::vector<double> C_org = util::create_random_matrix<double>(ld);
+
+  // small blocking, so that there are edge tiles on every level
+  memory_layout::blocking_configuration blocking;
+  blocking.L3_X = 20;
+  blocking.L3_Y = 32;
+  blocking.L3_K_STEP = 32;
+  blocking.L2_X = 10;
+  blocking.L2_Y = 16;
+  blocking.L2_K_STEP = 16;
+  blocking.L1_X = 10;
+  blocking.L1_Y = 8;
+  blocking.L1_K_STEP = 8;
+
+  for (bool transposed_A : {false, true}) {
+    for (bool transposed_B : {false, true}) {
+      for (double beta : {0.0, -0.5}) {
+        std::vector<double> C_reference(C_org);
+        naive_gemm(transposed_A, transposed_B, M, N, K, 1.5, A.data(), ld,
+                   B.data(), ld, beta, C_reference.data(), ld);
+        std::vector<double> C(C_org);
+        kernel_tiled::gemm(transposed_A, transposed_B, M, N, K, 1.5, A.data(),
+                           ld, B.data(), ld, beta, C.data(), ld, blocking);
+        // also checks that nothing outside of the M x N block was written
+        for (size_t i = 0; i < ld * ld; i++) {
+          BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(split_k) {
+
+  // a single L3 tile of C with a long k, so that k is split across threads
+  size_t ld = 256;
+  size_t M = 37;
+  size_t N = 29;
+  size_t K = 250;
+
+  std::vector<double> A = util::create_random_matrix<double>(ld);
+  std::vector<double> B = util::create_random_matrix<double>(ld);
+  std::vector<double> C_org = util::create_random_matrix<double>(ld);
+
+  memory_layout::blocking_configuration blocking;
+  blocking.L3_X = 70;
+  blocking.L3_Y = 48;
+  blocking.L3_K_STEP = 64;
+  blocking.L2_X = 70;
+  blocking.L2_Y = 48;
+  blocking.L2_K_STEP = 32;
+  blocking.L1_X = 35;
+  blocking.L1_Y = 16;
+  blocking.L1_K_STEP = 16;
+
+  int threads = omp_get_max_threads();
+  omp_set_num_threads(4);
+  for (auto schedule : {memory_layout::tile_schedule::static_schedule,
+                        memory_layout::tile_schedule::work_stealing}) {
+    memory_layout::set_tile_schedule(schedule);
+    for (double beta : {0.0, -0.5}) {
+      std::vector<double> C_reference(C_org);
+      naive_gemm(false, false, M, N, K, 1.5, A.data(), ld, B.data(), ld, beta,
+                 C_reference.data(), ld);
+      std::vector<double> C(C_org);
+      kernel_tiled::gemm(false, false, M, N, K, 1.5, A.data(), ld, B.data(),
+                         ld, beta, C.data(), ld, blocking);
+      for (size_t i = 0; i < ld * ld; i++) {
+        BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+      }
+    }
+  }
+  memory_layout::set_tile_schedule(
+      memory_layout::tile_schedule::static_schedule);
+  omp_set_num_threads(threads);
+}
+
+BOOST_AUTO_TEST_CASE(work_stealing_256) {
+
+  size_t N = 256;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+
+  std::vector<double> C_reference(N * N);
+  naive_gemm(false, false, N, N, N, 1.0, A.data(), N, B.data(), N, 0.0,
+             C_reference.data(), N);
+
+  // many small L3 tiles for the workers to steal
+  memory_layout::blocking_configuration blocking;
+  blocking.L3_X = 35;
+  blocking.L3_Y = 32;
+  blocking.L3_K_STEP = 128;
+  blocking.L2_X = 35;
+  blocking.L2_Y = 32;
+  blocking.L2_K_STEP = 64;
+  blocking.L1_X = 35;
+  blocking.L1_Y = 16;
+  blocking.L1_K_STEP = 32;
+
+  kernel_tiled::kernel_tiled<double> m(N, A, B, false, 1, 0, blocking);
+  m.set_schedule(memory_layout::tile_schedule::work_stealing);
+  double duration = 0.0;
+  std::vector<double> C = m.matrix_multiply(duration);
+
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(single_precision_100) {
+
+  size_t N = 100;
+
+  std::vector<float> A = util::create_random_matrix<float>(N);
+  std::vector<float> B = util::create_random_matrix<float>(N);
+
+  std::vector<float> C_reference(N * N);
+  naive_gemm(false, false, N, N, N, 1.0f, A.data(), N, B.data(), N, 0.0f,
+             C_reference.data(), N);
+
+  for (auto shape : micro_kernel::available_shapes<float>()) {
+    memory_layout::blocking_configuration blocking;
+    blocking.X_REG = shape.first;
+    blocking.Y_REG = shape.second;
+    blocking.L1_X = 2 * shape.first;
+    blocking.L1_Y = 2 * shape.second;
+    blocking.L1_K_STEP = 16;
+    blocking.L2_X = blocking.L1_X;
+    blocking.L2_Y = blocking.L1_Y;
+    blocking.L2_K_STEP = 32;
+    blocking.L3_X = 2 * blocking.L2_X;
+    blocking.L3_Y = 2 * blocking.L2_Y;
+    blocking.L3_K_STEP = 64;
+
+    kernel_tiled::kernel_tiled<float> m(N, A, B, false, 1, 0, blocking);
+    double duration = 0.0;
+    std::vector<float> C = m.matrix_multiply(duration);
+
+    for (size_t i = 0; i < N * N; i++) {
+      BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-3);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_blocking) {
+
+  size_t N = 8;
+  std::vector<double> A = util::create_identity_matrix<double>(N);
+  std::vector<double> B = util::create_identity_matrix<double>(N);
+
+  memory_layout::blocking_configuration not_nested;
+  not_nested.L2_X = 60; // not a multiple of L1_X = 35
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(N, A, B, false, 1, 0, not_nested),
+      memory_layout::memory_layout_exception);
+
+  memory_layout::blocking_configuration not_register_blocked;
+  not_register_blocked.L1_X = 32; // not a multiple of X_REG = 5
+  not_register_blocked.L2_X = 64;
+  not_register_blocked.L3_X = 256;
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(N, A, B, false, 1, 0,
+                                         not_register_blocked),
+      memory_layout::memory_layout_exception);
+
+  memory_layout::blocking_configuration unknown_micro_kernel;
+  unknown_micro_kernel.set_register_blocking("7x8");
+  unknown_micro_kernel.L1_X = 35;
+  BOOST_CHECK_THROW(
+      kernel_tiled::kernel_tiled<double>(N, A, B, false, 1, 0,
+                                         unknown_micro_kernel),
+      memory_layout::memory_layout_exception);
+  BOOST_CHECK_THROW(unknown_micro_kernel.set_register_blocking("5x"),
+                    memory_layout::memory_layout_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
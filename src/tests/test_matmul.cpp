@@ -0,0 +1,92 @@
+#define BOOST_TEST_DYN_LINK
+
+#include "matmul/matmul.hpp"
+#include "util/create_random_matrix.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_matmul)
+
+BOOST_AUTO_TEST_CASE(engines_with_strides) {
+  // embedded in 96 x 96 storage, only the M x N block of C may change
+  size_t ld = 96;
+  matmul::shape s{67, 45, 81};
+  matmul::strides st{ld, ld, ld};
+  std::vector<double> A = util::create_random_matrix<double>(ld);
+  std::vector<double> B = util::create_random_matrix<double>(ld);
+  std::vector<double> C_org = util::create_random_matrix<double>(ld);
+
+  for (bool transposed_A : {false, true}) {
+    for (bool transposed_B : {false, true}) {
+      matmul::options<double> opt;
+      opt.transposed_A = transposed_A;
+      opt.transposed_B = transposed_B;
+      opt.alpha = 0.5;
+      opt.beta = -2.0;
+      opt.strassen_cutoff = 16;
+      std::vector<double> C_reference(C_org);
+      matmul::gemm(matmul::engine::naive, s,
+                   {A.data(), B.data(), C_reference.data()}, st, opt);
+      for (matmul::engine e :
+           {matmul::engine::kernel_tiled, matmul::engine::strassen}) {
+        for (auto schedule : {memory_layout::tile_schedule::static_schedule,
+                              memory_layout::tile_schedule::work_stealing}) {
+          opt.schedule = schedule;
+          std::vector<double> C(C_org);
+          matmul::gemm(e, s, {A.data(), B.data(), C.data()}, st, opt);
+          for (size_t i = 0; i < ld * ld; i++) {
+            BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-9);
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(single_precision) {
+  size_t N = 70;
+  std::vector<float> A = util::create_random_matrix<float>(N);
+  std::vector<float> B = util::create_random_matrix<float>(N);
+  std::vector<float> C(N * N);
+  std::vector<float> C_reference(N * N);
+  matmul::gemm<float>(matmul::engine::naive, {N, N, N},
+                      {A.data(), B.data(), C_reference.data()}, {N, N, N});
+  matmul::gemm<float>(matmul::engine::kernel_tiled, {N, N, N},
+                      {A.data(), B.data(), C.data()}, {N, N, N});
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(degenerate_and_invalid) {
+  std::vector<double> A(4, 1.0);
+  std::vector<double> B(4, 1.0);
+  std::vector<double> C(4, 3.0);
+  matmul::options<double> opt;
+  opt.beta = 2.0;
+  // K = 0 only scales C
+  matmul::gemm(matmul::engine::kernel_tiled, {2, 2, 0},
+               {A.data(), B.data(), C.data()}, {2, 2, 2}, opt);
+  for (double c : C) {
+    BOOST_CHECK_EQUAL(c, 6.0);
+  }
+
+  BOOST_CHECK_THROW(matmul::gemm<double>(matmul::engine::kernel_tiled,
+                                         {2, 2, 2},
+                                         {A.data(), B.data(), C.data()},
+                                         {1, 2, 2}),
+                    util::matrix_multiplication_exception);
+  BOOST_CHECK_THROW(matmul::gemm<double>(matmul::engine::naive, {2, 2, 2},
+                                         {A.data(), nullptr, C.data()},
+                                         {2, 2, 2}),
+                    util::matrix_multiplication_exception);
+  BOOST_CHECK(matmul::engine_from_string("strassen") ==
+              matmul::engine::strassen);
+  BOOST_CHECK_THROW(matmul::engine_from_string("blas"),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
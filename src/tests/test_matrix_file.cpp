@@ -0,0 +1,129 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "reference_kernels/kernel_tiled.hpp"
+#include "util/matrix_file.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_matrix_file)
+
+namespace {
+
+// version 1 .npy file with the header dictionary dict, followed by data
+void write_npy(const std::string &file, std::string dict,
+               const std::string &data) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  dict.append(128 - 10 - dict.size() - 1, ' ');
+  dict.push_back('\n');
+  out << std::string("\x93NUMPY\x01\x00", 8) << static_cast<char>(dict.size())
+      << '\0' << dict << data;
+}
+}
+
+BOOST_AUTO_TEST_CASE(npy_round_trip) {
+  std::string file = "test_matrix_file_tmp.npy";
+  {
+    util::mapped_matrix m(file, 3, 5);
+    for (size_t i = 0; i < 15; i++) {
+      m.data()[i] = static_cast<double>(i) / 2.0;
+    }
+  }
+  {
+    // header as written by numpy.save, data aligned to 64 bytes
+    std::ifstream in(file, std::ios::binary);
+    std::string header(128, '\0');
+    in.read(&header[0], 128);
+    BOOST_CHECK_EQUAL(header.substr(0, 8), std::string("\x93NUMPY\x01\x00", 8));
+    BOOST_CHECK(header.find("{'descr': '<f8', 'fortran_order': False, "
+                            "'shape': (3, 5), }") == 10);
+    BOOST_CHECK_EQUAL(header[127], '\n');
+  }
+  util::mapped_matrix m(file);
+  BOOST_CHECK_EQUAL(m.get_rows(), 3);
+  BOOST_CHECK_EQUAL(m.get_cols(), 5);
+  for (size_t i = 0; i < 15; i++) {
+    BOOST_CHECK_EQUAL(m.data()[i], static_cast<double>(i) / 2.0);
+  }
+  std::remove(file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(raw_and_errors) {
+  std::string file = "test_matrix_file_tmp.bin";
+  {
+    util::mapped_matrix m(file, 4, 4);
+    for (size_t i = 0; i < 16; i++) {
+      m.data()[i] = static_cast<double>(i);
+    }
+  }
+  util::mapped_matrix raw(file);
+  BOOST_CHECK_EQUAL(raw.get_rows(), 4);
+  BOOST_CHECK_EQUAL(raw.data()[15], 15.0);
+  BOOST_CHECK_THROW(util::mapped_matrix(file, 2, 3),
+                    util::matrix_multiplication_exception);
+  {
+    // 3 doubles aren't square
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    double values[3] = {1.0, 2.0, 3.0};
+    out.write(reinterpret_cast<const char *>(values), sizeof(values));
+  }
+  BOOST_CHECK_THROW(util::mapped_matrix m(file),
+                    util::matrix_multiplication_exception);
+  std::remove(file.c_str());
+
+  std::string npy = "test_matrix_file_tmp.npy";
+  write_npy(npy,
+            "{'descr': '<f4', 'fortran_order': False, 'shape': (1, 1), }",
+            "abcd");
+  BOOST_CHECK_THROW(util::mapped_matrix m(npy),
+                    util::matrix_multiplication_exception);
+  // 2^61 x 8 doubles, the byte count wraps around to 0
+  write_npy(npy,
+            "{'descr': '<f8', 'fortran_order': False, 'shape': "
+            "(2305843009213693952, 8), }",
+            std::string(64, '\0'));
+  BOOST_CHECK_THROW(util::mapped_matrix m(npy),
+                    util::matrix_multiplication_exception);
+  BOOST_CHECK_THROW(util::mapped_matrix(npy, size_t(1) << 61, 8),
+                    util::matrix_multiplication_exception);
+  std::remove(npy.c_str());
+  BOOST_CHECK_THROW(util::mapped_matrix m("does_not_exist.npy"),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_CASE(kernel_tiled_from_mapping) {
+  size_t N = 37;
+  std::string file_A = "test_matrix_file_A_tmp.npy";
+  std::string file_C = "test_matrix_file_C_tmp.npy";
+  std::vector<double> B(N * N, 0.0);
+  {
+    util::mapped_matrix A(file_A, N, N);
+    for (size_t i = 0; i < N * N; i++) {
+      A.data()[i] = static_cast<double>(i % 13);
+    }
+  }
+  for (size_t i = 0; i < N; i++) {
+    B[i * N + i] = 2.0;
+  }
+  {
+    util::mapped_matrix A(file_A);
+    util::mapped_matrix C(file_C, N, N);
+    kernel_tiled::kernel_tiled<double> m(N, A.data(), B.data(), false, 2, 0);
+    double duration = 0.0;
+    m.matrix_multiply(C.data(), N, duration);
+    BOOST_CHECK_EQUAL(m.get_repetition_durations().size(), 2);
+  }
+  util::mapped_matrix C(file_C);
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_EQUAL(C.data()[i], 2.0 * static_cast<double>(i % 13));
+  }
+  std::remove(file_A.c_str());
+  std::remove(file_C.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
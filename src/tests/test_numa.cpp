@@ -0,0 +1,81 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <sched.h>
+
+#include <cstdint>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "memory_layout/memory_layout_exception.hpp"
+#include "memory_layout/numa.hpp"
+#include "memory_layout/page_allocator.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_numa)
+
+BOOST_AUTO_TEST_CASE(page_vector_aligned) {
+  memory_layout::page_vector<double> v(1000);
+  BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(v.data()) % 4096, 0);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = static_cast<double>(i);
+  }
+  memory_layout::page_vector<double> w(v);
+  BOOST_CHECK(w == v);
+  // explicit values are still initialized
+  memory_layout::page_vector<double> ones(1000, 1.0);
+  BOOST_CHECK_EQUAL(ones[999], 1.0);
+  // 2^62 bytes don't fit the address space
+  BOOST_CHECK_THROW(memory_layout::page_vector<double>(size_t(1) << 59),
+                    std::bad_alloc);
+}
+
+BOOST_AUTO_TEST_CASE(huge_pages_with_fallback) {
+  memory_layout::set_huge_pages(true);
+  // larger than a huge page and not a multiple of it
+  memory_layout::page_vector<double> v(400000, 2.0);
+  memory_layout::set_huge_pages(false);
+  memory_layout::page_backing backing =
+      memory_layout::get_page_backing(v.data());
+  if (backing != memory_layout::page_backing::small_pages) {
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(v.data()) % (2 << 20), 0);
+  }
+  BOOST_CHECK_EQUAL(v[399999], 2.0);
+
+  memory_layout::page_vector<double> w(1000);
+  BOOST_CHECK(memory_layout::get_page_backing(w.data()) ==
+              memory_layout::page_backing::small_pages);
+  BOOST_CHECK_THROW(memory_layout::get_page_backing(w.data() + 1),
+                    memory_layout::memory_layout_exception);
+}
+
+BOOST_AUTO_TEST_CASE(topology_and_binding) {
+  size_t nodes = memory_layout::numa::node_count();
+  BOOST_CHECK(nodes >= 1);
+  size_t node = memory_layout::numa::current_node();
+  BOOST_CHECK(node < nodes);
+  BOOST_CHECK(!memory_layout::numa::node_cpus(node).empty());
+
+  cpu_set_t mask;
+  BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(mask), &mask), 0);
+  memory_layout::numa::bind_to_node(node);
+  BOOST_CHECK_EQUAL(memory_layout::numa::current_node(), node);
+  sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+BOOST_AUTO_TEST_CASE(node_bandwidth_report) {
+  memory_layout::page_vector<double> v(1 << 16, 1.0);
+  std::stringstream out;
+  memory_layout::numa::print_node_bandwidth("v", v.data(),
+                                            v.size() * sizeof(double), out);
+  size_t lines = 0;
+  std::string line;
+  while (std::getline(out, line)) {
+    BOOST_CHECK_EQUAL(line.find("v on node "), 0);
+    lines++;
+  }
+  BOOST_CHECK_EQUAL(lines, memory_layout::numa::node_count());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "reference_kernels/naive.hpp"
+#include "reference_kernels/out_of_core.hpp"
+#include "util/create_random_matrix.hpp"
+#include "util/matrix_file.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_out_of_core)
+
+namespace {
+
+// rows x cols, the random matrices of the same size are equal, so that B is
+// taken from the end
+std::vector<double> random_matrix(size_t rows, size_t cols, bool from_end) {
+  std::vector<double> m = util::create_random_matrix<double>(rows + cols);
+  if (from_end) {
+    return std::vector<double>(m.end() - rows * cols, m.end());
+  }
+  return std::vector<double>(m.begin(), m.begin() + rows * cols);
+}
+
+memory_layout::blocking_configuration small_blocking() {
+  memory_layout::blocking_configuration blocking;
+  blocking.L3_X = 40;
+  blocking.L3_Y = 32;
+  blocking.L3_K_STEP = 32;
+  blocking.L2_X = 20;
+  blocking.L2_Y = 16;
+  blocking.L2_K_STEP = 16;
+  blocking.L1_X = 10;
+  blocking.L1_Y = 8;
+  blocking.L1_K_STEP = 8;
+  return blocking;
+}
+}
+
+BOOST_AUTO_TEST_CASE(panels_fit_the_budget) {
+  memory_layout::blocking_configuration blocking;
+  size_t N = 32768;
+  size_t budget = size_t(1) << 30;
+  out_of_core::panel_shape panels =
+      out_of_core::choose_panels(N, N, N, budget, 1, blocking);
+  BOOST_CHECK_EQUAL(panels.rows % blocking.L3_X, 0);
+  BOOST_CHECK_EQUAL(panels.cols, blocking.L3_Y);
+  BOOST_CHECK_LE(out_of_core::buffer_bytes(panels, N, blocking), budget);
+  // one more L3 tile of rows doesn't fit anymore
+  out_of_core::panel_shape larger = {panels.rows + blocking.L3_X,
+                                     panels.cols};
+  BOOST_CHECK_GT(out_of_core::buffer_bytes(larger, N, blocking), budget);
+
+  // every thread gets an L3 tile of C if the budget allows it
+  for (size_t parallel_budget : {budget, 16 * budget}) {
+    out_of_core::panel_shape parallel =
+        out_of_core::choose_panels(N, N, N, parallel_budget, 64, blocking);
+    size_t C_tiles =
+        (parallel.rows / blocking.L3_X) * (parallel.cols / blocking.L3_Y);
+    BOOST_CHECK_LE(out_of_core::buffer_bytes(parallel, N, blocking),
+                   parallel_budget);
+    BOOST_CHECK(parallel_budget == budget ? C_tiles == 4 : C_tiles >= 64);
+  }
+
+  // at least one L3 tile, at most the matrix
+  out_of_core::panel_shape tiny =
+      out_of_core::choose_panels(N, N, N, 1024, 1, blocking);
+  BOOST_CHECK_EQUAL(tiny.rows, blocking.L3_X);
+  BOOST_CHECK_EQUAL(tiny.cols, blocking.L3_Y);
+  out_of_core::panel_shape small =
+      out_of_core::choose_panels(100, 50, 100, budget, 1, blocking);
+  BOOST_CHECK_EQUAL(small.rows, 100);
+  BOOST_CHECK_EQUAL(small.cols, 50);
+
+  // k isn't padded, the packed copies are padded to the register blocking
+  // (5x8), as in kernel_tiled
+  BOOST_CHECK_EQUAL(out_of_core::buffer_bytes({97, 75}, 53, small_blocking()),
+                    (2 * 97 + 100 + 2 * 75 + 80) * 53 * sizeof(double));
+}
+
+BOOST_AUTO_TEST_CASE(streamed_tiles_97x75x53) {
+  size_t M = 97;
+  size_t N = 75;
+  size_t K = 53;
+  std::vector<double> A = random_matrix(M, K, false);
+  std::vector<double> B = random_matrix(K, N, true);
+
+  for (bool transposed : {false, true}) {
+    std::vector<double> C_reference(M * N);
+    naive_gemm(false, transposed, M, N, K, 1.0, A.data(), K, B.data(),
+               transposed ? K : N, 0.0, C_reference.data(), N);
+
+    // 3 x 3 tiles, the edge panels are partial
+    std::vector<double> C(M * N, -1.0);
+    std::vector<std::pair<size_t, size_t>> rows_done;
+    out_of_core::stream_statistics statistics;
+    out_of_core::gemm(M, N, K, A.data(), B.data(), transposed, C.data(),
+                      {40, 32}, small_blocking(),
+                      [&rows_done](size_t row_begin, size_t row_end) {
+                        rows_done.push_back({row_begin, row_end});
+                      },
+                      statistics);
+
+    for (size_t i = 0; i < M * N; i++) {
+      BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-10);
+    }
+    BOOST_CHECK_EQUAL(statistics.tiles, 9);
+    // A once, B three times except for the panels reused at the turns of
+    // the back and forth order (11 and 32 columns)
+    BOOST_CHECK_EQUAL(statistics.bytes_read,
+                      static_cast<double>((M + 3 * N - 11 - 32) * K) *
+                          sizeof(double));
+    std::vector<std::pair<size_t, size_t>> expected = {
+        {0, 40}, {40, 80}, {80, 97}};
+    BOOST_CHECK(rows_done == expected);
+  }
+
+  out_of_core::stream_statistics statistics;
+  BOOST_CHECK_THROW(out_of_core::gemm(M, N, 0, A.data(), B.data(), false,
+                                      nullptr, {40, 32}, small_blocking(),
+                                      [](size_t, size_t) {}, statistics),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_files) {
+  size_t M = 90;
+  size_t N = 70;
+  size_t K = 50;
+  std::string A_name = "test_out_of_core_A_tmp.npy";
+  std::string B_name = "test_out_of_core_B_tmp.npy";
+  std::string C_name = "test_out_of_core_C_tmp.npy";
+  std::vector<double> A = random_matrix(M, K, false);
+  std::vector<double> B = random_matrix(K, N, true);
+  {
+    util::mapped_matrix A_file(A_name, M, K);
+    util::mapped_matrix B_file(B_name, K, N);
+    std::copy(A.begin(), A.end(), A_file.data());
+    std::copy(B.begin(), B.end(), B_file.data());
+  }
+  std::vector<double> C_reference(M * N);
+  naive_gemm(false, false, M, N, K, 1.0, A.data(), K, B.data(), N, 0.0,
+             C_reference.data(), N);
+
+  {
+    util::mapped_matrix A_file(A_name, util::access_pattern::streamed);
+    util::mapped_matrix B_file(B_name, util::access_pattern::streamed);
+    util::mapped_matrix C_file(C_name, M, N);
+    // budget for one L3 tile each
+    out_of_core::out_of_core m(A_file, B_file, false, C_file, 2, 0, 1,
+                               small_blocking());
+    BOOST_CHECK_EQUAL(m.get_panels().rows, 40);
+    BOOST_CHECK_EQUAL(m.get_panels().cols, 32);
+    double duration = 0.0;
+    m.matrix_multiply(duration);
+    BOOST_CHECK_EQUAL(m.get_repetition_durations().size(), 2);
+    BOOST_CHECK_EQUAL(m.get_statistics().tiles, 18);
+
+    BOOST_CHECK_THROW(out_of_core::out_of_core(B_file, B_file, false, C_file,
+                                               1, 0, 1, small_blocking()),
+                      util::matrix_multiplication_exception);
+    BOOST_CHECK_THROW(A_file.write_back(0, 1),
+                      util::matrix_multiplication_exception);
+  }
+  util::mapped_matrix C_file(C_name);
+  BOOST_CHECK_EQUAL(C_file.get_rows(), M);
+  BOOST_CHECK_EQUAL(C_file.get_cols(), N);
+  for (size_t i = 0; i < M * N; i++) {
+    BOOST_CHECK_CLOSE(C_file.data()[i], C_reference[i], 1E-10);
+  }
+  std::remove(A_name.c_str());
+  std::remove(B_name.c_str());
+  std::remove(C_name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
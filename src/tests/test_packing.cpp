@@ -0,0 +1,105 @@
+#define BOOST_TEST_DYN_LINK
+
+#include "util/create_random_matrix.hpp"
+
+#include "memory_layout/packing.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace memory_layout::packing;
+
+BOOST_AUTO_TEST_SUITE(test_packing)
+
+BOOST_AUTO_TEST_CASE(edge_tiles_with_padding_37) {
+
+  // odd sizes, so that the tiles are neither aligned nor fully covered and
+  // the tiles at the edges are smaller
+  size_t N = 37;
+  size_t L1_X = 15;
+  size_t L1_Y = 12;
+  size_t L1_K_STEP = 16;
+  size_t X_size = 40;
+  size_t Y_size = 42;
+  size_t K_size = 42;
+
+  std::vector<double> M = util::create_random_matrix<double>(N);
+
+  std::vector<double> A_trans(X_size * K_size, -1.0);
+  pack_A<openmp_policy>(M.data(), N, N, N, false, A_trans.data(), X_size,
+                        K_size, L1_X, L1_K_STEP);
+  std::vector<double> B_tiled(K_size * Y_size, -1.0);
+  pack_B<openmp_policy>(M.data(), N, N, N, false, B_tiled.data(), Y_size,
+                        K_size, L1_Y, L1_K_STEP);
+
+  for (size_t x = 0; x < X_size; x++) {
+    for (size_t k = 0; k < K_size; k++) {
+      size_t x_begin = x - x % L1_X;
+      size_t k_begin = k - k % L1_K_STEP;
+      size_t A_index =
+          operand_tile_base(x_begin, k_begin, X_size, K_size, L1_X) +
+          (k - k_begin) * tile_extent(x_begin, X_size, L1_X) + x - x_begin;
+      double expected = x < N && k < N ? M[x * N + k] : 0.0;
+      BOOST_CHECK_EQUAL(A_trans[A_index], expected);
+    }
+  }
+  for (size_t k = 0; k < K_size; k++) {
+    for (size_t y = 0; y < Y_size; y++) {
+      size_t y_begin = y - y % L1_Y;
+      size_t k_begin = k - k % L1_K_STEP;
+      size_t B_index =
+          operand_tile_base(y_begin, k_begin, Y_size, K_size, L1_Y) +
+          (k - k_begin) * tile_extent(y_begin, Y_size, L1_Y) + y - y_begin;
+      double expected = k < N && y < N ? M[k * N + y] : 0.0;
+      BOOST_CHECK_EQUAL(B_tiled[B_index], expected);
+    }
+  }
+
+  // C is tiled in L1_X x L1_Y tiles, build one from M and unpack it
+  std::vector<double> C_tiled(X_size * Y_size, 0.0);
+  for (size_t x = 0; x < N; x++) {
+    for (size_t y = 0; y < N; y++) {
+      size_t x_begin = x - x % L1_X;
+      size_t y_begin = y - y % L1_Y;
+      C_tiled[result_tile_base(x_begin, y_begin, X_size, Y_size, L1_X) +
+              (x - x_begin) * tile_extent(y_begin, Y_size, L1_Y) + y -
+              y_begin] = M[x * N + y];
+    }
+  }
+  std::vector<double> C(N * N, -1.0);
+  unpack_C<openmp_policy>(C_tiled.data(), X_size, Y_size, L1_X, L1_Y, C.data(),
+                          N, N, N);
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_EQUAL(C[i], M[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pad_transposed_37) {
+
+  size_t N = 37;
+  size_t N_padded = 41;
+
+  std::vector<double> M = util::create_random_matrix<double>(N);
+
+  std::vector<double> M_trans(N_padded * N_padded, -1.0);
+  pad<openmp_policy>(M.data(), N, N, N, true, M_trans.data(), N_padded,
+                     N_padded);
+  for (size_t r = 0; r < N_padded; r++) {
+    for (size_t c = 0; c < N_padded; c++) {
+      double expected = r < N && c < N ? M[c * N + r] : 0.0;
+      BOOST_CHECK_EQUAL(M_trans[r * N_padded + c], expected);
+    }
+  }
+
+  std::vector<double> M_padded(N_padded * N_padded, -1.0);
+  pad<openmp_policy>(M.data(), N, N, N, false, M_padded.data(), N_padded,
+                     N_padded);
+  std::vector<double> M_unpadded(N * N);
+  unpad<openmp_policy>(M_padded.data(), N_padded, M_unpadded.data(), N, N);
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_EQUAL(M_unpadded[i], M[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
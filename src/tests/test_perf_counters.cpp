@@ -0,0 +1,64 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "util/perf_counters.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_perf_counters)
+
+BOOST_AUTO_TEST_CASE(measure_or_unavailable) {
+  util::perf_counters counters;
+  counters.start();
+  std::vector<double> v(1 << 20, 1.0);
+  double sum = 0.0;
+  for (double x : v) {
+    sum += x;
+  }
+  counters.stop();
+  BOOST_CHECK_EQUAL(sum, static_cast<double>(v.size()));
+
+  if (counters.is_available(util::perf_event::instructions)) {
+    BOOST_CHECK(counters.get(util::perf_event::instructions) > 0.0);
+  } else {
+    BOOST_CHECK_EQUAL(counters.get(util::perf_event::instructions), 0.0);
+  }
+
+  std::stringstream out;
+  counters.print("sum", out);
+  std::string line = out.str();
+  BOOST_CHECK_EQUAL(line.find("perf counters sum: cycles "), 0);
+  BOOST_CHECK(line.find("dTLB misses") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(phases_only_when_enabled) {
+  BOOST_CHECK(!util::get_perf_counters());
+  std::stringstream disabled_out;
+  { util::perf_phase disabled("disabled", disabled_out); }
+  BOOST_CHECK(disabled_out.str().empty());
+
+  util::set_perf_counters(true);
+  std::stringstream out;
+  {
+    util::perf_phase outer("outer", out);
+    // not measured separately
+    util::perf_phase inner("inner", out);
+  }
+  util::set_perf_counters(false);
+  // one line, also if the counters are not available
+  std::string line;
+  size_t lines = 0;
+  while (std::getline(out, line)) {
+    BOOST_CHECK_EQUAL(line.find("perf counters outer:"), 0);
+    lines++;
+  }
+  BOOST_CHECK_EQUAL(lines, 1);
+
+  BOOST_CHECK_EQUAL(util::to_string(util::perf_event::llc_misses),
+                    "LLC misses");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "util/matrix_multiplication_exception.hpp"
+#include "util/results.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+util::run_record make_record() {
+  util::run_record record;
+  record.algorithm = "kernel_tiled";
+  record.precision = "double";
+  record.M = 64;
+  record.N = 64;
+  record.K = 64;
+  record.transposed = true;
+  record.blocking = "L3: 64x64x64, L2: 32x32x32";
+  record.block_result = 128;
+  record.block_input = 128;
+  record.omp_threads = 2;
+  record.hpx_threads = 1;
+  record.repetitions = 2;
+  record.inner_durations = {0.25, 0.25};
+  record.total_duration = 1.0;
+  record.flops = 2E9;
+  record.padded_flops = 4E9;
+  record.verification = "passed";
+  return record;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(test_results)
+
+BOOST_AUTO_TEST_CASE(format_names) {
+  BOOST_CHECK(util::output_format_from_string("json") ==
+              util::output_format::json);
+  BOOST_CHECK(util::output_format_from_string("csv") ==
+              util::output_format::csv);
+  BOOST_CHECK(util::output_format_from_string("none") ==
+              util::output_format::none);
+  BOOST_CHECK_THROW(util::output_format_from_string("xml"),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_CASE(json_line) {
+  std::stringstream out;
+  util::write_json(make_record(), out);
+  std::string line = out.str();
+  BOOST_CHECK_EQUAL(line.find("{\"algorithm\": \"kernel_tiled\""), 0);
+  BOOST_CHECK(line.find("\"inner_durations\": [0.25, 0.25]") !=
+              std::string::npos);
+  // the rate is computed from the inner durations if there are any
+  BOOST_CHECK(line.find("\"gflops\": 8,") != std::string::npos);
+  BOOST_CHECK(line.find("\"padded_gflops\": 16,") != std::string::npos);
+  BOOST_CHECK(line.find("\"verification\": \"passed\"}\n") !=
+              std::string::npos);
+  BOOST_CHECK_EQUAL(line.find('\n'), line.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(csv_file) {
+  std::string file = "test_results_tmp.csv";
+  std::remove(file.c_str());
+  util::run_record record = make_record();
+  record.inner_durations.clear();
+  util::append_record(record, util::output_format::csv, file);
+  util::append_record(record, util::output_format::csv, file);
+
+  std::ifstream in(file);
+  std::string header, first, second, rest;
+  std::getline(in, header);
+  std::getline(in, first);
+  std::getline(in, second);
+  BOOST_CHECK(!std::getline(in, rest));
+  in.close();
+  std::remove(file.c_str());
+
+  BOOST_CHECK_EQUAL(header.find("algorithm,precision,M,N,K,"), 0);
+  BOOST_CHECK_EQUAL(first, second);
+  // the blocking contains a comma, the empty durations fall back to the total
+  BOOST_CHECK_EQUAL(first, "kernel_tiled,double,64,64,64,1,\"L3: 64x64x64, "
+                           "L2: 32x32x32\",128,128,2,1,2,,1,2000000000,"
+                           "4000000000,4,8,passed");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,46 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <sstream>
+#include <string>
+
+#include "reference_kernels/micro_kernel.hpp"
+#include "reference_kernels/roofline.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_roofline)
+
+BOOST_AUTO_TEST_CASE(fma_loop_flops) {
+  // two flops per multiply-add, 12 accumulators of vectors
+  double flops = micro_kernel::fma_loop<double>(100);
+  BOOST_CHECK(flops >= 2.0 * 100 * 12 * 2);
+  BOOST_CHECK_EQUAL(micro_kernel::fma_loop<float>(100), 2.0 * flops);
+}
+
+BOOST_AUTO_TEST_CASE(report_fractions) {
+  std::stringstream out;
+  // nothing is recorded while reporting is disabled
+  roofline::record_compute("disabled", 1.0, false);
+  roofline::print_report(out);
+  BOOST_CHECK(out.str().empty());
+
+  roofline::set_reporting(true);
+  const roofline::machine_peak &peak = roofline::get_machine_peak();
+  BOOST_CHECK(peak.gflops_double > 0.0);
+  BOOST_CHECK(peak.gflops_float > 0.0);
+  BOOST_CHECK(peak.bandwidth > 0.0);
+
+  roofline::record_compute("run", peak.gflops_double / 2.0, false);
+  roofline::record_bandwidth("packing", 1E9, 0.5);
+  roofline::print_report(out);
+  roofline::set_reporting(false);
+
+  std::string report = out.str();
+  BOOST_CHECK_EQUAL(report.find("machine peak: threads: "), 0);
+  BOOST_CHECK(report.find("run: ") != std::string::npos);
+  BOOST_CHECK(report.find("50% of compute peak") != std::string::npos);
+  BOOST_CHECK(report.find("packing: ") != std::string::npos);
+  BOOST_CHECK(report.find("% of bandwidth peak") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
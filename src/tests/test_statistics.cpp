@@ -0,0 +1,85 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "util/matrix_multiplication_exception.hpp"
+#include "util/statistics.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_statistics)
+
+BOOST_AUTO_TEST_CASE(t_quantiles) {
+  // two-sided 95% and 99% values from the tables
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.975, 1), 12.706, 0.01);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.975, 2), 4.303, 0.01);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.975, 3), 3.182, 0.5);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.975, 10), 2.228, 0.1);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.995, 5), 4.032, 0.5);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.975, 1000), 1.962, 0.1);
+  BOOST_CHECK_CLOSE(util::student_t_quantile(0.025, 10), -2.228, 0.1);
+  BOOST_CHECK_THROW(util::student_t_quantile(1.0, 10),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_CASE(summary) {
+  util::sample_summary s = util::summarize({4.0, 1.0, 3.0, 2.0}, 0.95);
+  BOOST_CHECK_EQUAL(s.count, 4);
+  BOOST_CHECK_EQUAL(s.mean, 2.5);
+  BOOST_CHECK_EQUAL(s.median, 2.5);
+  BOOST_CHECK_EQUAL(s.min, 1.0);
+  BOOST_CHECK_EQUAL(s.max, 4.0);
+  BOOST_CHECK_CLOSE(s.stddev, std::sqrt(5.0 / 3.0), 1E-10);
+  BOOST_CHECK_CLOSE(s.half_width, 3.182 * s.stddev / 2.0, 0.5);
+
+  util::sample_summary single = util::summarize({1.0}, 0.95);
+  BOOST_CHECK(std::isinf(single.half_width));
+  BOOST_CHECK_THROW(util::summarize({}, 0.95),
+                    util::matrix_multiplication_exception);
+
+  std::stringstream out;
+  out << s;
+  BOOST_CHECK_EQUAL(out.str().find("4 samples, mean: 2.5s"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(measure_converges) {
+  size_t calls = 0;
+  util::measurement_policy policy;
+  policy.warmup = 2;
+  policy.min_samples = 3;
+  util::measurement m = util::measure(
+      [&calls]() {
+        calls++;
+        return 1.0;
+      },
+      policy);
+  // identical samples converge as soon as min_samples are taken
+  BOOST_CHECK(m.converged);
+  BOOST_CHECK_EQUAL(m.samples.size(), 3);
+  BOOST_CHECK_EQUAL(calls, 5);
+}
+
+BOOST_AUTO_TEST_CASE(measure_limits) {
+  util::measurement_policy policy;
+  policy.warmup = 0;
+  policy.max_samples = 10;
+  policy.max_seconds = 1E10;
+  size_t calls = 0;
+  util::measurement m = util::measure(
+      [&calls]() { return calls++ % 2 == 0 ? 1.0 : 3.0; }, policy);
+  BOOST_CHECK(!m.converged);
+  BOOST_CHECK_EQUAL(m.samples.size(), 10);
+  BOOST_CHECK_EQUAL(m.summary.count, 10);
+
+  // the time budget ends the measurement after min_samples
+  policy.max_seconds = 2.0;
+  calls = 0;
+  m = util::measure([&calls]() { return calls++ % 2 == 0 ? 1.0 : 3.0; },
+                    policy);
+  BOOST_CHECK(!m.converged);
+  BOOST_CHECK_EQUAL(m.samples.size(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#define BOOST_TEST_DYN_LINK
+
+#include "util/create_random_matrix.hpp"
+#include "util/matrix_multiplication_exception.hpp"
+
+#include "memory_layout/blocking_configuration.hpp"
+#include "reference_kernels/naive.hpp"
+#include "reference_kernels/strassen.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_strassen)
+
+BOOST_AUTO_TEST_CASE(odd_dimensions) {
+
+  // all matrices are embedded in 128 x 128 storage to test leading dimensions
+  size_t ld = 128;
+  // odd on every level of the recursion
+  size_t M = 103;
+  size_t N = 87;
+  size_t K = 121;
+  size_t cutoff = 16;
+  BOOST_CHECK_EQUAL(strassen::levels(M, N, K, cutoff), 3);
+
+  std::vector<double> A = util::create_random_matrix<double>(ld);
+  std::vector<double> B = util::create_random_matrix<double>(ld);
+  std::vector<double> C_org = util::create_random_matrix<double>(ld);
+  std::vector<double> workspace(strassen::workspace_size(M, N, K, cutoff));
+
+  for (bool transposed_A : {false, true}) {
+    for (bool transposed_B : {false, true}) {
+      std::vector<double> C_reference(C_org);
+      naive_gemm(transposed_A, transposed_B, M, N, K, 1.0, A.data(), ld,
+                 B.data(), ld, 0.0, C_reference.data(), ld);
+      std::vector<double> C(C_org);
+      strassen::gemm(transposed_A, transposed_B, M, N, K, A.data(), ld,
+                     B.data(), ld, C.data(), ld, cutoff, workspace.data());
+      // also checks that nothing outside of the M x N block was written
+      for (size_t i = 0; i < ld * ld; i++) {
+        BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-9);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(square_with_error_report) {
+
+  size_t N = 200;
+
+  std::vector<double> A = util::create_random_matrix<double>(N);
+  std::vector<double> B = util::create_random_matrix<double>(N);
+
+  std::vector<double> C_reference(N * N);
+  naive_gemm(false, false, N, N, N, 1.0, A.data(), N, B.data(), N, 0.0,
+             C_reference.data(), N);
+
+  strassen::strassen<double> m(N, A, B, false, 1, 0, 50);
+  double duration = 0.0;
+  std::vector<double> C = m.matrix_multiply(duration);
+  for (size_t i = 0; i < N * N; i++) {
+    BOOST_CHECK_CLOSE(C[i], C_reference[i], 1E-9);
+  }
+
+  strassen::error_report report = m.compare_with_classical(C);
+  BOOST_CHECK_EQUAL(report.levels, 2);
+  BOOST_CHECK(report.normwise_difference < 1E-13);
+
+  BOOST_CHECK_THROW(strassen::strassen<double>(N, A, B, false, 1, 0, 0),
+                    util::matrix_multiplication_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
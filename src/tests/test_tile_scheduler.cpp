@@ -0,0 +1,68 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <vector>
+
+#include <omp.h>
+
+#include "memory_layout/memory_layout_exception.hpp"
+#include "memory_layout/tile_scheduler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_tile_scheduler)
+
+BOOST_AUTO_TEST_CASE(initial_chunks) {
+  // a single worker drains its own chunk first, in order
+  memory_layout::tile_scheduler scheduler(10, 3);
+  std::vector<size_t> tiles;
+  size_t tile;
+  while (scheduler.next(1, tile)) {
+    tiles.push_back(tile);
+  }
+  // own chunk [3, 6), then stolen from the back of worker 0 and worker 2
+  std::vector<size_t> expected = {3, 4, 5, 2, 1, 0, 9, 8, 7, 6};
+  BOOST_CHECK_EQUAL_COLLECTIONS(tiles.begin(), tiles.end(), expected.begin(),
+                                expected.end());
+
+  // the last worker steals from its neighbor first, not from worker 0
+  memory_layout::tile_scheduler last(8, 4);
+  tiles.clear();
+  while (last.next(3, tile)) {
+    tiles.push_back(tile);
+  }
+  expected = {6, 7, 5, 4, 3, 2, 1, 0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(tiles.begin(), tiles.end(), expected.begin(),
+                                expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(every_tile_once) {
+  const size_t tiles = 1000;
+  std::vector<int> counts(tiles, 0);
+  // more workers than threads, some chunks are only reachable by stealing
+  memory_layout::tile_scheduler scheduler(tiles, 8);
+#pragma omp parallel num_threads(4)
+  {
+    size_t tile;
+    while (scheduler.next(omp_get_thread_num(), tile)) {
+#pragma omp atomic
+      counts[tile]++;
+    }
+  }
+  for (size_t i = 0; i < tiles; i++) {
+    BOOST_CHECK_EQUAL(counts[i], 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(schedule_names) {
+  BOOST_CHECK(memory_layout::tile_schedule_from_string("stealing") ==
+              memory_layout::tile_schedule::work_stealing);
+  BOOST_CHECK_EQUAL(
+      memory_layout::to_string(memory_layout::tile_schedule::static_schedule),
+      "static");
+  BOOST_CHECK_THROW(memory_layout::tile_schedule_from_string("dynamic"),
+                    memory_layout::memory_layout_exception);
+  BOOST_CHECK_THROW(memory_layout::tile_scheduler(10, 0),
+                    memory_layout::memory_layout_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,17 +1,11 @@
 #include <random>
 #include <vector>
 
+#include "generate_matrix.hpp"
+
 namespace util {
 
 template <typename T> std::vector<T> create_identity_matrix(size_t N) {
-
-  std::vector<T> m(N * N);
-	std::fill(m.begin(), m.end(), 0.0);
-
-	for (size_t i = 0; i < N; i++) {
-		m[i * N + i] = 1.0;
-	}
-
-  return m;
+  return generate_matrix<T>(matrix_pattern::identity, N, N);
 }
 }
@@ -3,17 +3,12 @@
 #include <functional>
 #include <algorithm>
 
+#include "generate_matrix.hpp"
+
 namespace util {
 
+// uniform [0, 1), generated in parallel, the same matrix for every N x N
 template <typename T> std::vector<T> create_random_matrix(size_t N) {
-
-  std::vector<T> m(N * N);
-
-  std::default_random_engine generator;
-  std::uniform_real_distribution<double> distribution(0.0, 1.0);
-  auto myRand = std::bind(distribution, generator);
-
-  std::generate(m.begin(), m.end(), myRand);
-  return m;
+  return generate_matrix<T>(matrix_pattern::uniform, N, N);
 }
 }
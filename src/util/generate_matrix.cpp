@@ -0,0 +1,184 @@
+#include "generate_matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "matrix_multiplication_exception.hpp"
+
+namespace util {
+
+namespace {
+
+const std::uint64_t golden_gamma = 0x9e3779b97f4a7c15ULL;
+
+// finalizer of SplitMix64, a bijection that mixes all bits
+std::uint64_t mix(std::uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+std::uint64_t block_key(std::uint64_t seed, size_t block) {
+  return mix(mix(seed) ^ ((static_cast<std::uint64_t>(block) + 1) *
+                          golden_gamma));
+}
+
+// element offset of the SplitMix64 sequence of the block
+std::uint64_t uniform_bits(std::uint64_t key, size_t offset) {
+  return mix(key + (static_cast<std::uint64_t>(offset) + 1) * golden_gamma);
+}
+
+// in [0, 1) with 53 random bits
+double uniform(std::uint64_t key, size_t offset) {
+  return static_cast<double>(uniform_bits(key, offset) >> 11) *
+         (1.0 / 9007199254740992.0);
+}
+
+// in [0, 1) in the precision of T, rounding the 53 bits of uniform() to float
+// gives 1 for values from 1 - 2^-25 on, float takes the top 24 bits instead
+// (the double value truncated to float)
+template <typename T> T uniform_as(std::uint64_t key, size_t offset) {
+  return uniform(key, offset);
+}
+
+template <> float uniform_as<float>(std::uint64_t key, size_t offset) {
+  return static_cast<float>(uniform_bits(key, offset) >> 40) *
+         (1.0f / 16777216.0f);
+}
+
+// Box-Muller, the elements 2 i and 2 i + 1 of a block share their uniform
+// pair, the block size is even
+double normal(std::uint64_t key, size_t offset) {
+  const double pi = 3.14159265358979323846;
+  size_t pair = offset / 2 * 2;
+  double radius = std::sqrt(-2.0 * std::log(1.0 - uniform(key, pair)));
+  double angle = 2.0 * pi * uniform(key, pair + 1);
+  return offset % 2 == 0 ? radius * std::cos(angle)
+                         : radius * std::sin(angle);
+}
+}
+
+std::string to_string(matrix_pattern pattern) {
+  switch (pattern) {
+  case matrix_pattern::normal:
+    return "normal";
+  case matrix_pattern::identity:
+    return "identity";
+  case matrix_pattern::diagonal:
+    return "diagonal";
+  case matrix_pattern::enumerating:
+    return "enumerating";
+  default:
+    return "uniform";
+  }
+}
+
+matrix_pattern matrix_pattern_from_string(const std::string &name) {
+  for (matrix_pattern pattern :
+       {matrix_pattern::uniform, matrix_pattern::normal,
+        matrix_pattern::identity, matrix_pattern::diagonal,
+        matrix_pattern::enumerating}) {
+    if (name.compare(to_string(pattern)) == 0) {
+      return pattern;
+    }
+  }
+  throw matrix_multiplication_exception(
+      "unknown matrix pattern \"" + name +
+      "\", use uniform, normal, identity, diagonal or enumerating");
+}
+
+size_t generator_blocks(size_t rows, size_t cols) {
+  return (rows * cols + generator_block_size - 1) / generator_block_size;
+}
+
+void openmp_block_loop(size_t blocks,
+                       const std::function<void(size_t)> &body) {
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < blocks; block++) {
+    body(block);
+  }
+}
+
+template <typename T>
+void generate_block(matrix_pattern pattern, size_t rows, size_t cols,
+                    const generator_options &options, size_t block, T *m) {
+  size_t begin = block * generator_block_size;
+  size_t end = std::min(begin + generator_block_size, rows * cols);
+  // position (row, col) in the stored matrix
+  size_t stored_cols = options.transposed ? rows : cols;
+  size_t row = begin / stored_cols;
+  size_t col = begin % stored_cols;
+  // the key of the block of the pattern matrix the element belongs to, the
+  // same block if not transposed
+  size_t key_block = block;
+  std::uint64_t key = block_key(options.seed, key_block);
+  for (size_t index = begin; index < end; index++) {
+    size_t i = options.transposed ? col : row;
+    size_t j = options.transposed ? row : col;
+    size_t pattern_index = i * cols + j;
+    if (pattern_index / generator_block_size != key_block) {
+      key_block = pattern_index / generator_block_size;
+      key = block_key(options.seed, key_block);
+    }
+    size_t offset = pattern_index % generator_block_size;
+
+    double value;
+    switch (pattern) {
+    case matrix_pattern::normal:
+      value = normal(key, offset);
+      break;
+    case matrix_pattern::identity:
+      value = i == j ? 1.0 : 0.0;
+      break;
+    case matrix_pattern::diagonal:
+      value = i == j ? uniform_as<T>(key, offset) : 0.0;
+      break;
+    case matrix_pattern::enumerating:
+      value = static_cast<double>(pattern_index);
+      break;
+    default:
+      value = uniform_as<T>(key, offset);
+    }
+    m[index] = static_cast<T>(value);
+
+    col += 1;
+    if (col == stored_cols) {
+      col = 0;
+      row += 1;
+    }
+  }
+}
+
+template <typename T>
+void generate_matrix(matrix_pattern pattern, size_t rows, size_t cols, T *m,
+                     const generator_options &options,
+                     const block_loop &loop) {
+  loop(generator_blocks(rows, cols), [&](size_t block) {
+    generate_block(pattern, rows, cols, options, block, m);
+  });
+}
+
+template <typename T>
+std::vector<T> generate_matrix(matrix_pattern pattern, size_t rows,
+                               size_t cols, const generator_options &options,
+                               const block_loop &loop) {
+  std::vector<T> m(rows * cols);
+  generate_matrix(pattern, rows, cols, m.data(), options, loop);
+  return m;
+}
+
+#define INSTANTIATE_GENERATE_MATRIX(T)                                         \
+  template void generate_block<T>(matrix_pattern, size_t, size_t,              \
+                                  const generator_options &, size_t, T *);     \
+  template void generate_matrix<T>(matrix_pattern, size_t, size_t, T *,        \
+                                   const generator_options &,                  \
+                                   const block_loop &);                        \
+  template std::vector<T> generate_matrix<T>(                                  \
+      matrix_pattern, size_t, size_t, const generator_options &,               \
+      const block_loop &);
+
+INSTANTIATE_GENERATE_MATRIX(double)
+INSTANTIATE_GENERATE_MATRIX(float)
+
+#undef INSTANTIATE_GENERATE_MATRIX
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// Parallel, deterministic input matrices. The elements are split into blocks
+// of generator_block_size consecutive elements (of the row-major pattern
+// matrix), every block has its own key derived from the seed and the block
+// index, and an element is a function of the key of its block and its offset
+// in the block (counter-based, SplitMix64). The blocks can therefore be
+// generated in any order and by any number of threads, the result is always
+// bit-identical.
+
+// uniform: [0, 1), normal: mean 0 and standard deviation 1, identity,
+// diagonal: uniform [0, 1) on the diagonal, enumerating: element i is i
+enum class matrix_pattern { uniform, normal, identity, diagonal, enumerating };
+
+std::string to_string(matrix_pattern pattern);
+
+// throws matrix_multiplication_exception for unknown names
+matrix_pattern matrix_pattern_from_string(const std::string &name);
+
+struct generator_options {
+  std::uint64_t seed = 0;
+  // store the transpose of the pattern matrix, a rows x cols pattern is
+  // stored cols x rows, the elements don't change
+  bool transposed = false;
+};
+
+// elements of a block, a power of two, so that it doesn't depend on anything
+const size_t generator_block_size = 16384;
+
+// blocks of a matrix with rows x cols elements
+size_t generator_blocks(size_t rows, size_t cols);
+
+// runs body(block) for every block in [0, blocks), in any order
+using block_loop =
+    std::function<void(size_t blocks, const std::function<void(size_t)> &body)>;
+
+// the default loop, an OpenMP parallel for
+void openmp_block_loop(size_t blocks, const std::function<void(size_t)> &body);
+
+// fills the elements of block of the stored matrix m (row-major, rows x cols,
+// or cols x rows if transposed)
+template <typename T>
+void generate_block(matrix_pattern pattern, size_t rows, size_t cols,
+                    const generator_options &options, size_t block, T *m);
+
+// fills the stored matrix m (rows x cols elements) block by block
+template <typename T>
+void generate_matrix(matrix_pattern pattern, size_t rows, size_t cols, T *m,
+                     const generator_options &options = generator_options(),
+                     const block_loop &loop = openmp_block_loop);
+
+template <typename T>
+std::vector<T>
+generate_matrix(matrix_pattern pattern, size_t rows, size_t cols,
+                const generator_options &options = generator_options(),
+                const block_loop &loop = openmp_block_loop);
+}
@@ -0,0 +1,302 @@
+#include "matrix_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix_multiplication_exception.hpp"
+
+namespace util {
+
+namespace {
+
+const char npy_magic[] = "\x93NUMPY";
+const size_t npy_magic_size = 6;
+// the data of the files written here starts at a multiple of this
+const size_t npy_alignment = 64;
+
+// closes the descriptor when leaving the constructors, the mapping stays
+class file_descriptor {
+public:
+  int fd;
+  explicit file_descriptor(int fd) : fd(fd) {}
+  ~file_descriptor() {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+};
+
+std::string npy_header(size_t rows, size_t cols) {
+  std::stringstream dict;
+  dict << "{'descr': '<f8', 'fortran_order': False, 'shape': (" << rows
+       << ", " << cols << "), }";
+  std::string header = dict.str();
+  // magic, version, length, dictionary, newline
+  size_t unpadded = npy_magic_size + 2 + 2 + header.size() + 1;
+  size_t padded =
+      (unpadded + npy_alignment - 1) / npy_alignment * npy_alignment;
+  header.append(padded - unpadded, ' ');
+  header.push_back('\n');
+  uint16_t length = static_cast<uint16_t>(header.size());
+  std::string prefix(npy_magic, npy_magic_size);
+  prefix.push_back('\x01');
+  prefix.push_back('\x00');
+  prefix.push_back(static_cast<char>(length & 0xff));
+  prefix.push_back(static_cast<char>(length >> 8));
+  return prefix + header;
+}
+
+// bytes of rows x cols doubles, the shape of a .npy header can be anything,
+// so that the product may not fit into size_t
+size_t matrix_bytes(const std::string &file_name, size_t rows, size_t cols) {
+  if (rows != 0 && cols > (SIZE_MAX / sizeof(double)) / rows) {
+    throw matrix_multiplication_exception(
+        "the shape of \"" + file_name + "\" (" + std::to_string(rows) + ", " +
+        std::to_string(cols) + ") is too large to be addressed");
+  }
+  return rows * cols * sizeof(double);
+}
+
+// value of key in the header dictionary, up to the next top level comma
+std::string npy_value(const std::string &header, const std::string &key) {
+  size_t key_position = header.find("'" + key + "'");
+  if (key_position == std::string::npos) {
+    return "";
+  }
+  size_t begin = header.find(':', key_position);
+  if (begin == std::string::npos) {
+    return "";
+  }
+  begin += 1;
+  size_t end = begin;
+  int depth = 0;
+  while (end < header.size() && (depth > 0 || header[end] != ',')) {
+    if (header[end] == '(') {
+      depth += 1;
+    } else if (header[end] == ')') {
+      depth -= 1;
+    } else if (header[end] == '}' && depth == 0) {
+      break;
+    }
+    end += 1;
+  }
+  std::string value = header.substr(begin, end - begin);
+  size_t first = value.find_first_not_of(" ");
+  size_t last = value.find_last_not_of(" ");
+  return first == std::string::npos ? ""
+                                    : value.substr(first, last - first + 1);
+}
+}
+
+bool is_npy_file(const std::string &file_name) {
+  return file_name.size() >= 4 &&
+         file_name.compare(file_name.size() - 4, 4, ".npy") == 0;
+}
+
+mapped_matrix::mapped_matrix(const std::string &file_name,
+                             access_pattern access)
+    : file_name(file_name), mapping(nullptr), mapping_size(0),
+      elements(nullptr), rows(0), cols(0), writable(false) {
+  file_descriptor file(open(file_name.c_str(), O_RDONLY));
+  if (file.fd < 0) {
+    throw matrix_multiplication_exception("could not open matrix file \"" +
+                                          file_name + "\"");
+  }
+  struct stat status;
+  if (fstat(file.fd, &status) != 0 || status.st_size == 0) {
+    throw matrix_multiplication_exception("matrix file \"" + file_name +
+                                          "\" is empty");
+  }
+  mapping_size = static_cast<size_t>(status.st_size);
+  mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw matrix_multiplication_exception("could not map matrix file \"" +
+                                          file_name + "\"");
+  }
+  if (access == access_pattern::whole) {
+    // the packing reads all of it soon
+    madvise(mapping, mapping_size, MADV_WILLNEED);
+  }
+
+  try {
+    if (is_npy_file(file_name)) {
+      parse_npy_header(mapping_size);
+    } else {
+      if (mapping_size % sizeof(double) != 0) {
+        throw matrix_multiplication_exception("raw matrix file \"" +
+                                              file_name +
+                                              "\" isn't a sequence of doubles");
+      }
+      size_t count = mapping_size / sizeof(double);
+      size_t N = static_cast<size_t>(std::llround(std::sqrt(count)));
+      if (N * N != count) {
+        throw matrix_multiplication_exception(
+            "raw matrix file \"" + file_name +
+            "\" doesn't hold a square matrix, use .npy for other shapes");
+      }
+      rows = N;
+      cols = N;
+      elements = static_cast<double *>(mapping);
+    }
+  } catch (...) {
+    munmap(mapping, mapping_size);
+    throw;
+  }
+}
+
+void mapped_matrix::parse_npy_header(size_t file_size) {
+  const char *bytes = static_cast<const char *>(mapping);
+  if (file_size < npy_magic_size + 4 ||
+      std::memcmp(bytes, npy_magic, npy_magic_size) != 0) {
+    throw matrix_multiplication_exception("\"" + file_name +
+                                          "\" is not a .npy file");
+  }
+  uint8_t major = static_cast<uint8_t>(bytes[npy_magic_size]);
+  const unsigned char *length_bytes =
+      reinterpret_cast<const unsigned char *>(bytes + npy_magic_size + 2);
+  size_t header_offset;
+  size_t header_length;
+  if (major == 1) {
+    header_offset = npy_magic_size + 4;
+    header_length = length_bytes[0] | (length_bytes[1] << 8);
+  } else if (major == 2 || major == 3) {
+    header_offset = npy_magic_size + 6;
+    if (file_size < header_offset) {
+      throw matrix_multiplication_exception("truncated .npy file \"" +
+                                            file_name + "\"");
+    }
+    header_length = static_cast<size_t>(length_bytes[0]) |
+                    (static_cast<size_t>(length_bytes[1]) << 8) |
+                    (static_cast<size_t>(length_bytes[2]) << 16) |
+                    (static_cast<size_t>(length_bytes[3]) << 24);
+  } else {
+    throw matrix_multiplication_exception("unsupported .npy version in \"" +
+                                          file_name + "\"");
+  }
+  if (file_size < header_offset + header_length) {
+    throw matrix_multiplication_exception("truncated .npy file \"" +
+                                          file_name + "\"");
+  }
+  std::string header(bytes + header_offset, header_length);
+
+  std::string descr = npy_value(header, "descr");
+  if (descr.compare("'<f8'") != 0) {
+    throw matrix_multiplication_exception(
+        "\"" + file_name + "\" has element type " + descr +
+        ", only little-endian float64 ('<f8') is supported");
+  }
+  if (npy_value(header, "fortran_order").compare("False") != 0) {
+    throw matrix_multiplication_exception(
+        "\"" + file_name + "\" is in Fortran order, save a C-contiguous "
+                           "array (numpy.ascontiguousarray)");
+  }
+  std::string shape = npy_value(header, "shape");
+  unsigned long long r, c;
+  char closing;
+  if (std::sscanf(shape.c_str(), " ( %llu , %llu %c", &r, &c, &closing) != 3 ||
+      (closing != ')' && closing != ',')) {
+    throw matrix_multiplication_exception(
+        "\"" + file_name + "\" has shape " + shape +
+        ", only two-dimensional arrays are supported");
+  }
+  rows = r;
+  cols = c;
+  size_t data_offset = header_offset + header_length;
+  if (file_size - data_offset < matrix_bytes(file_name, rows, cols)) {
+    throw matrix_multiplication_exception("truncated .npy file \"" +
+                                          file_name + "\"");
+  }
+  if (data_offset % sizeof(double) != 0) {
+    throw matrix_multiplication_exception(
+        "the data of \"" + file_name + "\" isn't aligned to doubles");
+  }
+  elements = reinterpret_cast<double *>(static_cast<char *>(mapping) +
+                                        data_offset);
+}
+
+mapped_matrix::mapped_matrix(const std::string &file_name, size_t rows,
+                             size_t cols)
+    : file_name(file_name), mapping(nullptr), mapping_size(0),
+      elements(nullptr), rows(rows), cols(cols), writable(true) {
+  bool npy = is_npy_file(file_name);
+  if (!npy && rows != cols) {
+    throw matrix_multiplication_exception(
+        "raw matrix files have to be square, use .npy for \"" + file_name +
+        "\"");
+  }
+  size_t data_bytes = matrix_bytes(file_name, rows, cols);
+  std::string header = npy ? npy_header(rows, cols) : "";
+  if (data_bytes > SIZE_MAX - header.size()) {
+    throw matrix_multiplication_exception(
+        "\"" + file_name + "\" is too large to be addressed");
+  }
+  mapping_size = header.size() + data_bytes;
+  if (mapping_size == 0) {
+    throw matrix_multiplication_exception("empty matrix for \"" + file_name +
+                                          "\"");
+  }
+
+  file_descriptor file(
+      open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+  if (file.fd < 0) {
+    throw matrix_multiplication_exception("could not create matrix file \"" +
+                                          file_name + "\"");
+  }
+  if (ftruncate(file.fd, static_cast<off_t>(mapping_size)) != 0) {
+    throw matrix_multiplication_exception(
+        "could not allocate space for matrix file \"" + file_name + "\"");
+  }
+  mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 file.fd, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw matrix_multiplication_exception("could not map matrix file \"" +
+                                          file_name + "\"");
+  }
+  std::memcpy(mapping, header.data(), header.size());
+  elements =
+      reinterpret_cast<double *>(static_cast<char *>(mapping) + header.size());
+}
+
+void mapped_matrix::write_back(size_t row_begin, size_t row_end) {
+  if (!writable) {
+    throw matrix_multiplication_exception("\"" + file_name +
+                                          "\" is mapped read-only");
+  }
+  if (row_begin >= row_end) {
+    return;
+  }
+  // msync() and madvise() work on whole pages, the neighboring rows that
+  // share the first and the last page are written as well
+  size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  char *base = static_cast<char *>(mapping);
+  size_t begin = reinterpret_cast<char *>(elements + row_begin * cols) - base;
+  size_t end = reinterpret_cast<char *>(elements + row_end * cols) - base;
+  begin = begin / page_size * page_size;
+  end = std::min((end + page_size - 1) / page_size * page_size, mapping_size);
+  if (msync(base + begin, end - begin, MS_SYNC) != 0) {
+    throw matrix_multiplication_exception("could not write rows of \"" +
+                                          file_name + "\"");
+  }
+  // the pages are clean now, unmapping them from the process keeps the
+  // resident set small, they stay in the page cache until the kernel
+  // reclaims them
+  madvise(base + begin, end - begin, MADV_DONTNEED);
+}
+
+mapped_matrix::~mapped_matrix() {
+  if (mapping != nullptr) {
+    munmap(mapping, mapping_size);
+  }
+}
+}
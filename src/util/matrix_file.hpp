@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace util {
+
+// how a mapped input is going to be read: whole matrices are prefetched when
+// mapped, streamed ones are read panel by panel, only when needed
+enum class access_pattern { whole, streamed };
+
+// A row-major matrix of doubles in a memory-mapped file, either a NumPy .npy
+// file (little-endian float64, C order, two dimensions) or, for any other
+// extension, raw little-endian doubles of a square matrix. The elements are
+// read from and written to the page cache directly, without a copy.
+class mapped_matrix {
+private:
+  std::string file_name;
+  void *mapping;
+  size_t mapping_size;
+  double *elements;
+  size_t rows;
+  size_t cols;
+  bool writable;
+
+  void parse_npy_header(size_t file_size);
+
+public:
+  // maps an existing file read-only, raw files have to hold N * N doubles,
+  // throws matrix_multiplication_exception if the file can't be read or has
+  // an unsupported format
+  explicit mapped_matrix(const std::string &file_name,
+                         access_pattern access = access_pattern::whole);
+
+  // creates (or truncates) the file with space for rows x cols elements,
+  // mapped read-write and written back by the kernel, raw files have to be
+  // square
+  mapped_matrix(const std::string &file_name, size_t rows, size_t cols);
+
+  mapped_matrix(const mapped_matrix &) = delete;
+  mapped_matrix &operator=(const mapped_matrix &) = delete;
+
+  ~mapped_matrix();
+
+  size_t get_rows() const { return rows; }
+  size_t get_cols() const { return cols; }
+
+  const double *data() const { return elements; }
+  double *data() { return elements; }
+
+  // writes the rows [row_begin, row_end) to the file and drops them from the
+  // address space, blocks until they are on disk, only for created files,
+  // throws matrix_multiplication_exception if the write fails
+  void write_back(size_t row_begin, size_t row_end);
+};
+
+// whether file_name ends in ".npy"
+bool is_npy_file(const std::string &file_name);
+}
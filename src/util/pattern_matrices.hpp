@@ -1,16 +1,12 @@
 #include <random>
 #include <vector>
 
+#include "generate_matrix.hpp"
+
 namespace util {
 
+// element i is i
 template <typename T> std::vector<T> create_enumerating_matrix(size_t N) {
-
-  std::vector<T> m(N * N);
-
-  for (size_t i = 0; i < N * N; i++) {
-    m[i] = static_cast<double>(i);
-  }
-
-  return m;
+  return generate_matrix<T>(matrix_pattern::enumerating, N, N);
 }
 }
@@ -0,0 +1,227 @@
+#include "perf_counters.hpp"
+
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace util {
+
+namespace {
+
+std::atomic<bool> perf_counters_enabled(false);
+
+// only the outermost phase is measured
+std::atomic<bool> phase_active(false);
+
+struct event_config {
+  perf_event event;
+  uint32_t type;
+  uint64_t config;
+  uint64_t weight;
+};
+
+uint64_t cache_event(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool is_intel() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 9, "vendor_id") == 0) {
+      return line.find("GenuineIntel") != std::string::npos;
+    }
+  }
+  return false;
+}
+
+std::vector<event_config> event_configs() {
+  std::vector<event_config> configs = {
+      {perf_event::cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1},
+      {perf_event::instructions, PERF_TYPE_HARDWARE,
+       PERF_COUNT_HW_INSTRUCTIONS, 1},
+      {perf_event::l1d_misses, PERF_TYPE_HW_CACHE,
+       cache_event(PERF_COUNT_HW_CACHE_L1D), 1},
+      {perf_event::llc_misses, PERF_TYPE_HW_CACHE,
+       cache_event(PERF_COUNT_HW_CACHE_LL), 1},
+      {perf_event::dtlb_misses, PERF_TYPE_HW_CACHE,
+       cache_event(PERF_COUNT_HW_CACHE_DTLB), 1}};
+  if (is_intel()) {
+    // FP_ARITH_INST_RETIRED (event 0xC7, Broadwell and later), one umask per
+    // precision and vector width, weighted with the elements per instruction
+    const uint64_t umasks[][2] = {{0x01, 1}, {0x02, 1}, {0x04, 2},
+                                  {0x08, 4}, {0x10, 4}, {0x20, 8}};
+    for (const auto &umask : umasks) {
+      configs.push_back({perf_event::fp_ops, PERF_TYPE_RAW,
+                         0xC7 | (umask[0] << 8), umask[1]});
+    }
+  }
+  return configs;
+}
+
+std::vector<pid_t> process_threads() {
+  std::vector<pid_t> threads;
+  DIR *dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    threads.push_back(0);
+    return threads;
+  }
+  while (struct dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      threads.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+    }
+  }
+  closedir(dir);
+  return threads;
+}
+
+int open_event(const event_config &config, pid_t thread) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = config.type;
+  attr.config = config.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &attr, thread, -1, -1, 0));
+}
+}
+
+std::string to_string(perf_event event) {
+  switch (event) {
+  case perf_event::cycles:
+    return "cycles";
+  case perf_event::instructions:
+    return "instructions";
+  case perf_event::l1d_misses:
+    return "L1D misses";
+  case perf_event::llc_misses:
+    return "LLC misses";
+  case perf_event::dtlb_misses:
+    return "dTLB misses";
+  default:
+    return "FP ops";
+  }
+}
+
+void set_perf_counters(bool enabled) { perf_counters_enabled = enabled; }
+
+bool get_perf_counters() { return perf_counters_enabled; }
+
+perf_counters::perf_counters()
+    : values(perf_event_count, 0.0), available(perf_event_count, false) {
+#pragma omp parallel
+  {
+    // only creates the threads of the team
+  }
+  std::vector<event_config> configs = event_configs();
+  for (pid_t thread : process_threads()) {
+    for (const event_config &config : configs) {
+      int fd = open_event(config, thread);
+      if (fd >= 0) {
+        counters.push_back({config.event, config.weight, fd});
+        available[static_cast<size_t>(config.event)] = true;
+      }
+    }
+  }
+}
+
+perf_counters::~perf_counters() {
+  for (const counter &c : counters) {
+    close(c.fd);
+  }
+}
+
+void perf_counters::start() {
+  for (const counter &c : counters) {
+    ioctl(c.fd, PERF_EVENT_IOC_RESET, 0);
+  }
+  for (const counter &c : counters) {
+    ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void perf_counters::stop() {
+  for (const counter &c : counters) {
+    ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+  std::fill(values.begin(), values.end(), 0.0);
+  for (const counter &c : counters) {
+    // value, time enabled, time running
+    uint64_t data[3];
+    if (read(c.fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+      continue;
+    }
+    // extrapolated if the counter was multiplexed with others
+    double scale =
+        static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    values[static_cast<size_t>(c.event)] +=
+        static_cast<double>(data[0]) * scale * static_cast<double>(c.weight);
+  }
+}
+
+bool perf_counters::is_available(perf_event event) const {
+  return available[static_cast<size_t>(event)];
+}
+
+double perf_counters::get(perf_event event) const {
+  return values[static_cast<size_t>(event)];
+}
+
+void perf_counters::print(const std::string &phase, std::ostream &out) const {
+  std::stringstream line;
+  line << "perf counters " << phase << ":";
+  bool any = false;
+  for (size_t e = 0; e < perf_event_count; e++) {
+    perf_event event = static_cast<perf_event>(e);
+    line << (e == 0 ? " " : ", ") << to_string(event) << " ";
+    if (is_available(event)) {
+      line << get(event);
+      any = true;
+    } else {
+      line << "n/a";
+    }
+  }
+  if (is_available(perf_event::cycles) &&
+      is_available(perf_event::instructions) && get(perf_event::cycles) > 0) {
+    line << ", IPC "
+         << (get(perf_event::instructions) / get(perf_event::cycles));
+  }
+  if (!any) {
+    line << " (not available, check /proc/sys/kernel/perf_event_paranoid)";
+  }
+  out << line.str() << std::endl;
+}
+
+perf_phase::perf_phase(const std::string &name, std::ostream &out)
+    : name(name), out(out) {
+  bool expected = false;
+  if (perf_counters_enabled &&
+      phase_active.compare_exchange_strong(expected, true)) {
+    counters.reset(new perf_counters());
+    counters->start();
+  }
+}
+
+perf_phase::~perf_phase() {
+  if (counters) {
+    counters->stop();
+    counters->print(name, out);
+    counters.reset();
+    phase_active = false;
+  }
+}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// Linux hardware performance counters (perf_event_open) for all threads of
+// the process, i.e. the OpenMP team and the HPX worker threads. Without
+// counter access (no permission, see /proc/sys/kernel/perf_event_paranoid,
+// virtual machines, other operating systems) the counters are reported as
+// unavailable and the measured code runs unchanged. Only depends on the
+// standard library, so that the benchmark in otherExperiments can use it.
+
+enum class perf_event {
+  cycles,
+  instructions,
+  l1d_misses,  // L1 data cache read misses
+  llc_misses,  // last level cache read misses
+  dtlb_misses, // data TLB read misses
+  fp_ops       // floating point operations (FMA counts twice), Intel only
+};
+
+const size_t perf_event_count = 6;
+
+std::string to_string(perf_event event);
+
+// whether engines measure their phases with perf_phase, off by default
+void set_perf_counters(bool enabled);
+
+bool get_perf_counters();
+
+class perf_counters {
+private:
+  struct counter {
+    perf_event event;
+    // multiplier of the raw count, e.g. vector width for the fp events
+    uint64_t weight;
+    int fd;
+  };
+
+  std::vector<counter> counters;
+  // counts of the last start() to stop() interval, scaled if the events were
+  // multiplexed
+  std::vector<double> values;
+  std::vector<bool> available;
+
+public:
+  // opens the events for every thread that currently exists in the process,
+  // starts the OpenMP team first, so that its threads are included
+  perf_counters();
+
+  ~perf_counters();
+
+  perf_counters(const perf_counters &) = delete;
+
+  perf_counters &operator=(const perf_counters &) = delete;
+
+  // resets and enables all counters
+  void start();
+
+  // disables the counters and reads them
+  void stop();
+
+  // whether at least one counter of the event could be opened
+  bool is_available(perf_event event) const;
+
+  // value of the last measurement, 0 if not available
+  double get(perf_event event) const;
+
+  // a line with all events of the last measurement, unavailable events are
+  // printed as "n/a"
+  void print(const std::string &phase, std::ostream &out = std::cout) const;
+};
+
+// Measures a phase of an engine (packing, compute) if set_perf_counters(true)
+// was called and prints the counters when the phase ends. Phases nested into
+// another phase are not measured separately, e.g. the packing of the leaves
+// of strassen counts towards its compute phase.
+class perf_phase {
+private:
+  std::string name;
+  std::ostream &out;
+  std::unique_ptr<perf_counters> counters;
+
+public:
+  // the counters are printed to out, which has to outlive the phase
+  explicit perf_phase(const std::string &name, std::ostream &out = std::cout);
+
+  ~perf_phase();
+
+  perf_phase(const perf_phase &) = delete;
+
+  perf_phase &operator=(const perf_phase &) = delete;
+};
+}
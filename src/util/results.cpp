@@ -0,0 +1,167 @@
+#include "results.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "matrix_multiplication_exception.hpp"
+
+namespace util {
+
+namespace {
+
+std::string json_string(const std::string &s) {
+  std::stringstream out;
+  out << '"';
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    default:
+      out << c;
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+// quoted if necessary, the blocking contains commas
+std::string csv_field(const std::string &s) {
+  if (s.find_first_of(",\"\n") == std::string::npos) {
+    return s;
+  }
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+double sum(const std::vector<double> &values) {
+  double s = 0.0;
+  for (double v : values) {
+    s += v;
+  }
+  return s;
+}
+
+// rate of all repetitions, with the inner time if it was measured
+double gflops(const run_record &record, double flops) {
+  double seconds = record.inner_durations.empty()
+                       ? record.total_duration
+                       : sum(record.inner_durations);
+  return seconds > 0.0 ? record.repetitions * flops / seconds / 1E9 : 0.0;
+}
+}
+
+output_format output_format_from_string(const std::string &name) {
+  if (name.compare("none") == 0) {
+    return output_format::none;
+  } else if (name.compare("json") == 0) {
+    return output_format::json;
+  } else if (name.compare("csv") == 0) {
+    return output_format::csv;
+  }
+  throw matrix_multiplication_exception("unknown output format \"" + name +
+                                        "\", use none, json or csv");
+}
+
+void write_json(const run_record &record, std::ostream &out) {
+  std::stringstream line;
+  line << std::setprecision(std::numeric_limits<double>::max_digits10);
+  line << "{\"algorithm\": " << json_string(record.algorithm)
+       << ", \"precision\": " << json_string(record.precision)
+       << ", \"M\": " << record.M << ", \"N\": " << record.N
+       << ", \"K\": " << record.K
+       << ", \"transposed\": " << (record.transposed ? "true" : "false")
+       << ", \"blocking\": " << json_string(record.blocking)
+       << ", \"block_result\": " << record.block_result
+       << ", \"block_input\": " << record.block_input
+       << ", \"omp_threads\": " << record.omp_threads
+       << ", \"hpx_threads\": " << record.hpx_threads
+       << ", \"repetitions\": " << record.repetitions
+       << ", \"inner_durations\": [";
+  for (size_t i = 0; i < record.inner_durations.size(); i++) {
+    line << (i == 0 ? "" : ", ") << record.inner_durations[i];
+  }
+  line << "], \"total_duration\": " << record.total_duration
+       << ", \"flops\": " << record.flops
+       << ", \"padded_flops\": " << record.padded_flops
+       << ", \"gflops\": " << gflops(record, record.flops)
+       << ", \"padded_gflops\": " << gflops(record, record.padded_flops)
+       << ", \"verification\": " << json_string(record.verification) << "}";
+  out << line.str() << std::endl;
+}
+
+void write_csv_header(std::ostream &out) {
+  out << "algorithm,precision,M,N,K,transposed,blocking,block_result,"
+         "block_input,omp_threads,hpx_threads,repetitions,inner_durations,"
+         "total_duration,flops,padded_flops,gflops,padded_gflops,"
+         "verification"
+      << std::endl;
+}
+
+void write_csv(const run_record &record, std::ostream &out) {
+  std::stringstream line;
+  line << std::setprecision(std::numeric_limits<double>::max_digits10);
+  line << csv_field(record.algorithm) << "," << csv_field(record.precision)
+       << "," << record.M << "," << record.N << "," << record.K << ","
+       << (record.transposed ? 1 : 0) << "," << csv_field(record.blocking)
+       << "," << record.block_result << "," << record.block_input << ","
+       << record.omp_threads << "," << record.hpx_threads << ","
+       << record.repetitions << ",";
+  for (size_t i = 0; i < record.inner_durations.size(); i++) {
+    line << (i == 0 ? "" : " ") << record.inner_durations[i];
+  }
+  line << "," << record.total_duration << "," << record.flops << ","
+       << record.padded_flops << "," << gflops(record, record.flops) << ","
+       << gflops(record, record.padded_flops) << ","
+       << csv_field(record.verification);
+  out << line.str() << std::endl;
+}
+
+void append_record(const run_record &record, output_format format,
+                   const std::string &file) {
+  if (format == output_format::none) {
+    return;
+  }
+  if (file.empty()) {
+    if (format == output_format::csv) {
+      write_csv_header(std::cout);
+      write_csv(record, std::cout);
+    } else {
+      write_json(record, std::cout);
+    }
+    return;
+  }
+  bool is_new = true;
+  {
+    std::ifstream existing(file);
+    is_new = !existing || existing.peek() == std::ifstream::traits_type::eof();
+  }
+  std::ofstream out(file, std::ios::app);
+  if (!out) {
+    throw matrix_multiplication_exception("could not open results file \"" +
+                                          file + "\"");
+  }
+  if (format == output_format::csv) {
+    if (is_new) {
+      write_csv_header(out);
+    }
+    write_csv(record, out);
+  } else {
+    write_json(record, out);
+  }
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// one run of the matrix_multiply application in a machine-readable form
+struct run_record {
+  std::string algorithm;
+  std::string precision;
+  // op(A) is M x K, op(B) K x N
+  size_t M;
+  size_t N;
+  size_t K;
+  bool transposed;
+  // as printed by the blocking_configuration, empty for algorithms without
+  std::string blocking;
+  uint64_t block_result;
+  uint64_t block_input;
+  size_t omp_threads;
+  size_t hpx_threads;
+  uint64_t repetitions;
+  // inner (compute only) time of every repetition, empty if the algorithm
+  // doesn't measure it
+  std::vector<double> inner_durations;
+  // time measured by the driver for all repetitions
+  double total_duration;
+  // 2 M N K
+  double flops;
+  // including the padding the algorithm computes, equal to flops without
+  double padded_flops;
+  // "passed", "failed" or "not checked"
+  std::string verification;
+};
+
+enum class output_format { none, json, csv };
+
+// "none", "json" or "csv", throws matrix_multiplication_exception otherwise
+output_format output_format_from_string(const std::string &name);
+
+// a single JSON object on one line
+void write_json(const run_record &record, std::ostream &out);
+
+// the inner durations are a single field separated by spaces
+void write_csv_header(std::ostream &out);
+
+void write_csv(const run_record &record, std::ostream &out);
+
+// Appends the record to file, to stdout if file is empty. JSON files hold one
+// object per line (JSON Lines), CSV files get the header when they are
+// created, so that repeated runs accumulate in one file.
+void append_record(const run_record &record, output_format format,
+                   const std::string &file);
+}
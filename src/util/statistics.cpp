@@ -0,0 +1,155 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "matrix_multiplication_exception.hpp"
+
+namespace util {
+
+namespace {
+
+// Acklam's rational approximation, relative error below 1.2E-9
+double normal_quantile(double p) {
+  const double a[] = {-3.969683028665376E+01, 2.209460984245205E+02,
+                      -2.759285104469687E+02, 1.383577518672690E+02,
+                      -3.066479806614716E+01, 2.506628277459239E+00};
+  const double b[] = {-5.447609879822406E+01, 1.615858368580409E+02,
+                      -1.556989798598866E+02, 6.680131188771972E+01,
+                      -1.328068155288572E+01};
+  const double c[] = {-7.784894002430293E-03, -3.223964580411365E-01,
+                      -2.400758277161838E+00, -2.549732539343734E+00,
+                      4.374664141464968E+00,  2.938163982698783E+00};
+  const double d[] = {7.784695709041462E-03, 3.224671290700398E-01,
+                      2.445134137142996E+00, 3.754408661907416E+00};
+  const double p_low = 0.02425;
+  if (p < p_low) {
+    double q = std::sqrt(-2.0 * std::log(p));
+    return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q +
+            c[5]) /
+           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  } else if (p <= 1.0 - p_low) {
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r +
+            a[5]) *
+           q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r +
+                1.0);
+  }
+  return -normal_quantile(1.0 - p);
+}
+}
+
+double student_t_quantile(double p, size_t degrees) {
+  if (p <= 0.0 || p >= 1.0 || degrees == 0) {
+    throw matrix_multiplication_exception(
+        "t quantile needs 0 < p < 1 and at least one degree of freedom");
+  }
+  const double pi = 3.14159265358979323846;
+  if (degrees == 1) {
+    return std::tan(pi * (p - 0.5));
+  } else if (degrees == 2) {
+    return (2.0 * p - 1.0) / std::sqrt(2.0 * p * (1.0 - p));
+  }
+  // Abramowitz and Stegun 26.7.5
+  double z = normal_quantile(p);
+  double z2 = z * z;
+  double n = static_cast<double>(degrees);
+  double g1 = (z2 + 1.0) * z / 4.0;
+  double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+  double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+  double g4 =
+      ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z /
+      92160.0;
+  return z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+}
+
+sample_summary summarize(const std::vector<double> &samples,
+                         double confidence) {
+  if (samples.empty()) {
+    throw matrix_multiplication_exception("no samples to summarize");
+  }
+  if (confidence <= 0.0 || confidence >= 1.0) {
+    throw matrix_multiplication_exception(
+        "confidence has to be in (0, 1), e.g. 0.95");
+  }
+  sample_summary summary;
+  summary.count = samples.size();
+  summary.confidence = confidence;
+
+  std::vector<double> sorted(samples);
+  std::sort(sorted.begin(), sorted.end());
+  summary.min = sorted.front();
+  summary.max = sorted.back();
+  size_t middle = sorted.size() / 2;
+  summary.median = sorted.size() % 2 == 1
+                       ? sorted[middle]
+                       : (sorted[middle - 1] + sorted[middle]) / 2.0;
+
+  double sum = 0.0;
+  for (double s : samples) {
+    sum += s;
+  }
+  summary.mean = sum / summary.count;
+
+  if (summary.count < 2) {
+    summary.stddev = 0.0;
+    summary.half_width = std::numeric_limits<double>::infinity();
+    return summary;
+  }
+  double squares = 0.0;
+  for (double s : samples) {
+    squares += (s - summary.mean) * (s - summary.mean);
+  }
+  summary.stddev = std::sqrt(squares / (summary.count - 1));
+  summary.half_width =
+      student_t_quantile(0.5 + confidence / 2.0, summary.count - 1) *
+      summary.stddev / std::sqrt(static_cast<double>(summary.count));
+  return summary;
+}
+
+std::ostream &operator<<(std::ostream &out, const sample_summary &summary) {
+  out << summary.count << " samples, mean: " << summary.mean
+      << "s, stddev: " << summary.stddev << "s, min: " << summary.min
+      << "s, median: " << summary.median << "s, max: " << summary.max
+      << "s, " << (summary.confidence * 100.0) << "% confidence: +-";
+  if (summary.count < 2) {
+    out << "n/a";
+  } else {
+    out << (summary.half_width / summary.mean * 100.0) << "%";
+  }
+  return out;
+}
+
+measurement measure(const std::function<double()> &sample,
+                    const measurement_policy &policy) {
+  if (policy.min_samples == 0 || policy.max_samples < policy.min_samples) {
+    throw matrix_multiplication_exception(
+        "need 0 < min samples <= max samples");
+  }
+  for (size_t i = 0; i < policy.warmup; i++) {
+    sample();
+  }
+  measurement m;
+  m.converged = false;
+  double elapsed = 0.0;
+  while (m.samples.size() < policy.max_samples) {
+    double duration = sample();
+    m.samples.push_back(duration);
+    elapsed += duration;
+    if (m.samples.size() < policy.min_samples) {
+      continue;
+    }
+    m.summary = summarize(m.samples, policy.confidence);
+    if (m.summary.half_width <= policy.relative_precision * m.summary.mean) {
+      m.converged = true;
+      break;
+    }
+    if (elapsed >= policy.max_seconds) {
+      break;
+    }
+  }
+  return m;
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace util {
+
+// quantile of Student's t distribution with the given degrees of freedom,
+// exact for 1 and 2 degrees, otherwise a Cornish-Fisher expansion around the
+// normal quantile (relative error below 0.5% for p <= 0.995)
+double student_t_quantile(double p, size_t degrees);
+
+struct sample_summary {
+  size_t count;
+  double mean;
+  // sample standard deviation, 0 for fewer than two samples
+  double stddev;
+  double min;
+  double median;
+  double max;
+  double confidence;
+  // half width of the confidence interval of the mean, infinite for fewer
+  // than two samples
+  double half_width;
+};
+
+// throws matrix_multiplication_exception if samples is empty or confidence
+// isn't in (0, 1)
+sample_summary summarize(const std::vector<double> &samples,
+                         double confidence);
+
+std::ostream &operator<<(std::ostream &out, const sample_summary &summary);
+
+struct measurement_policy {
+  // runs that are discarded, e.g. to fault in the pages of the buffers
+  size_t warmup = 1;
+  size_t min_samples = 3;
+  size_t max_samples = 30;
+  // stop once the half width of the confidence interval of the mean is at
+  // most this fraction of the mean
+  double relative_precision = 0.02;
+  double confidence = 0.95;
+  // stop after the samples took this long, even if the target precision
+  // wasn't reached (min_samples are taken in any case)
+  double max_seconds = 60.0;
+};
+
+struct measurement {
+  std::vector<double> samples;
+  sample_summary summary;
+  // whether the target precision was reached
+  bool converged;
+};
+
+// calls sample until the policy is satisfied, sample returns the duration of
+// one run in seconds
+measurement measure(const std::function<double()> &sample,
+                    const measurement_policy &policy);
+}
@@ -4,6 +4,9 @@
 #include <cstdint>
 #include <vector>
 
+#include "memory_layout/blocking_configuration.hpp"
+#include "memory_layout/page_allocator.hpp"
+
 namespace combined {
 
 class combined {
@@ -14,18 +17,39 @@ private:
   std::size_t Y_size;
   std::size_t K_size;
 
-  std::vector<double> A;
-  std::vector<double> B;
+  // packed into L1 tiles by the constructor, the packing threads touch the
+  // pages first, so that they are distributed over the NUMA nodes
+  memory_layout::page_vector<double> A_trans;
+  memory_layout::page_vector<double> B_padded;
 
   uint64_t repetitions;
   uint64_t verbose;
 
+  memory_layout::blocking_configuration blocking;
+
+  // of the last matrix_multiply()
+  std::vector<double> repetition_durations;
+
   void verify_blocking_setup();
 
 public:
+  // B is read in its transposed storage order if transposed
   combined(size_t N, std::vector<double> &A, std::vector<double> &B,
-           uint64_t repetitions, uint64_t verbose);
+           bool transposed, uint64_t repetitions, uint64_t verbose,
+           const memory_layout::blocking_configuration &blocking =
+               memory_layout::blocking_configuration());
 
   std::vector<double> matrix_multiply(double &duration);
+
+  // inner time of every repetition of the last matrix_multiply()
+  const std::vector<double> &get_repetition_durations() const {
+    return repetition_durations;
+  }
+
+  // floating point operations including the padding that is computed
+  double get_padded_flops() const {
+    return 2.0 * static_cast<double>(X_size) * static_cast<double>(Y_size) *
+           static_cast<double>(K_size);
+  }
 };
 }
@@ -5,7 +5,12 @@
 #include "hpx/parallel/execution_policy.hpp"
 #include "hpx/util/iterator_facade.hpp"
 #include <boost/iterator/iterator_facade.hpp>
+#include <hpx/include/async.hpp>
 #include <hpx/include/iostreams.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include "memory_layout/tile_scheduler.hpp"
 
 namespace index_iterator {
 
@@ -130,7 +135,8 @@ public:
 
 template <typename T> class blocking_pseudo_execution_policy {
 public:
-  blocking_pseudo_execution_policy(size_t dim) : dim(dim) {
+  blocking_pseudo_execution_policy(size_t dim)
+      : dim(dim), schedule(memory_layout::tile_schedule::static_schedule) {
     this->add_blocking(std::vector<T>(dim, static_cast<T>(1)),
                        std::vector<bool>(dim, false));
   }
@@ -158,9 +164,19 @@ public:
     std::get<0>(blocking_configuration[0]) = steps;
   }
 
+  // distribution of the blocks of the parallel dimensions over the worker
+  // threads, for_each_n(par) by default
+  void set_schedule(memory_layout::tile_schedule schedule) {
+    this->schedule = schedule;
+  }
+
+  memory_layout::tile_schedule get_schedule() const { return schedule; }
+
 private:
   size_t dim;
 
+  memory_layout::tile_schedule schedule;
+
   std::vector<std::pair<std::vector<T>, std::vector<bool>>>
       blocking_configuration;
 };
@@ -271,8 +287,7 @@ void iterate_indices(blocking_pseudo_execution_policy<T> policy,
                                            block_reduced);
 
     // first process parallel dimensions
-    hpx::parallel::for_each_n(
-        hpx::parallel::par, dim_iter_reduced, inner_index_count_reduced,
+    auto process_block =
         [parallel_dims_count, inner_index_count_remain, &policy, &map, &min,
          &max, &block, f](const std::vector<size_t> &partial_index) {
           std::vector<T> min_serial_fill(min);
@@ -318,15 +333,16 @@ void iterate_indices(blocking_pseudo_execution_policy<T> policy,
           hpx::parallel::for_each_n(
               hpx::parallel::seq, dim_iter_serial_fill,
               inner_index_count_remain,
-              [&policy, &block, f, &recursive_min,
+              [&policy, &block, &max, f, &recursive_min,
                &recursive_max](const std::vector<size_t> &cur_index) {
                 // iterate within block
                 for (size_t d = 0; d < dim; d++) {
                   recursive_min[d] = cur_index[d];
                 }
 
+                // the last block is clipped if the range isn't a multiple
                 for (size_t d = 0; d < dim; d++) {
-                  recursive_max[d] = cur_index[d] + block[d];
+                  recursive_max[d] = std::min(cur_index[d] + block[d], max[d]);
                 }
 
                 //                                hpx::cout << "recursive_min:
@@ -357,7 +373,39 @@ void iterate_indices(blocking_pseudo_execution_policy<T> policy,
                 iterate_indices<dim>(policy, recursive_min, recursive_max, f);
               });
 
-        });
+        };
+
+    // levels without parallel dimensions have a single block
+    if (parallel_dims_count == 0 ||
+        policy.get_schedule() ==
+            memory_layout::tile_schedule::static_schedule) {
+      hpx::parallel::for_each_n(hpx::parallel::par, dim_iter_reduced,
+                                inner_index_count_reduced, process_block);
+    } else {
+      // the blocks are numbered in iteration order, so that every worker
+      // starts with a contiguous chunk, one task per worker thread
+      std::vector<std::vector<T>> partial_indices;
+      partial_indices.reserve(inner_index_count_reduced);
+      hpx::parallel::for_each_n(
+          hpx::parallel::seq, dim_iter_reduced, inner_index_count_reduced,
+          [&partial_indices](const std::vector<size_t> &partial_index) {
+            partial_indices.push_back(partial_index);
+          });
+      memory_layout::tile_scheduler scheduler(partial_indices.size(),
+                                              hpx::get_os_thread_count());
+      std::vector<hpx::future<void>> workers;
+      workers.reserve(scheduler.get_workers());
+      for (size_t worker = 0; worker < scheduler.get_workers(); worker++) {
+        workers.push_back(hpx::async(
+            [&scheduler, &partial_indices, &process_block, worker]() {
+              size_t tile;
+              while (scheduler.next(worker, tile)) {
+                process_block(partial_indices[tile]);
+              }
+            }));
+      }
+      hpx::wait_all(workers);
+    }
   }
 }
 }
@@ -3,9 +3,9 @@
 #include <chrono>
 
 #include "index_iterator.hpp"
+#include "memory_layout/packing_hpx.hpp"
 #include "memory_layout/tile_array.hpp"
 #include "memory_layout/tile_view.hpp"
-#include "util/transpose_matrix.hpp"
 
 #include <hpx/include/iostreams.hpp>
 
@@ -105,21 +105,12 @@ proposal::proposal(size_t N, std::vector<double> &A_org,
   A_trans =
       std::vector<double, boost::alignment::aligned_allocator<double, 32>>(
           K_size * X_size);
-  std::fill(A_trans.begin(), A_trans.end(), 0.0);
-  for (size_t x = 0; x < N_org; x++) {
-    for (size_t k = 0; k < N_org; k++) {
-      A_trans.at(x * K_size + k) = A_org.at(x * N + k);
-    }
-  }
-  A_trans = util::transpose_matrix(K_size, X_size, A_trans);
+  memory_layout::packing::pad<memory_layout::packing::hpx_policy>(
+      A_org.data(), N, N, N, true, A_trans.data(), K_size, X_size);
   B = std::vector<double, boost::alignment::aligned_allocator<double, 32>>(
       K_size * Y_size);
-  std::fill(B.begin(), B.end(), 0.0);
-  for (size_t y = 0; y < N_org; y++) {
-    for (size_t k = 0; k < N_org; k++) {
-      B.at(k * Y_size + y) = B_org.at(k * N + y);
-    }
-  }
+  memory_layout::packing::pad<memory_layout::packing::hpx_policy>(
+      B_org.data(), N, N, N, false, B.data(), K_size, Y_size);
 }
 
 std::vector<double> proposal::matrix_multiply(double &duration) {
@@ -314,11 +305,8 @@ std::vector<double> proposal::matrix_multiply(double &duration) {
 
   std::vector<double, boost::alignment::aligned_allocator<double, 32>> C_untiled_padded = memory_layout::undo_tiling<2>(C_padded_tiled, tiling_info_C);
   std::vector<double> C_return(N_org * N_org);
-  for (size_t x = 0; x < N_org; x += 1) {
-    for (size_t y = 0; y < N_org; y += 1) {
-      C_return[x * N_org + y] = C_untiled_padded[x * Y_size + y];
-    }
-  }
+  memory_layout::packing::unpad<memory_layout::packing::hpx_policy>(
+      C_untiled_padded.data(), Y_size, C_return.data(), N_org, N_org);
 
 
 